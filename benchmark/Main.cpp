@@ -7,9 +7,13 @@
 #include <JuceHeader.h>
 #include <algorithm>
 #include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <fstream>
 
+#include "../src/services/Trace.h"
 #include "../src/synth/SynthEngine.h"
 #include "../tests/dsp/util/PositionInfoMock.h"
+#include "PerfCounters.h"
 
 //==============================================================================
 // Constants
@@ -43,6 +47,7 @@ constexpr int VEL_OFF = 0x00;
 
 //==============================================================================
 
+template <typename SampleType>
 class SynthEngineFixture : public benchmark::Fixture
 {
 public:
@@ -99,6 +104,23 @@ public:
         masterParams->setMasterFineTunePtr (&masterFineTune);
         masterParams->setPortamentoPtr (&portamento);
         masterParams->setMasterVolumePtr (&masterVolume);
+        masterParams->setSoftClipOnPtr (&softClipOn);
+
+        // Modulation parameters
+        onsen::ModulationParams* const modulationParams = synthParams.modulation();
+        modulationParams->setControlIntervalPtr (&modControlInterval);
+        modulationParams->setPitchControlRatePtr (&pitchModControlRate);
+        modulationParams->setFilterControlRatePtr (&filterModControlRate);
+        modulationParams->setShapeControlRatePtr (&shapeModControlRate);
+        modulationParams->setEnvPitchPtr (&envPitch);
+        modulationParams->setEnvShapePtr (&envShape);
+        synthParams.compileModulationMatrix();
+
+        // Unison parameters
+        onsen::UnisonParams* const unisonParams = synthParams.unison();
+        unisonParams->setNumVoicesPtr (&unisonVoices);
+        unisonParams->setDetunePtr (&unisonDetune);
+        unisonParams->setSpreadPtr (&unisonSpread);
 
         synthEngine.prepareToPlay (NUM_SAMPLE, SAMPLE_RATE);
 
@@ -117,12 +139,111 @@ public:
         synthEngine.renderNextBlock (outputAudio, inputMidiBuffer, 0, NUM_SAMPLE);
     }
 
+    // The loop of a benchmark. With $OS251_PERF_COUNTERS=1, it also reports
+    // the hardware counters per rendered sample and per sample of each
+    // active voice.
+    void renderLoop (benchmark::State& state)
+    {
+        if (! onsen::PerfCounters::isRequested())
+        {
+            for (auto _ : state)
+            {
+                render();
+            }
+            return;
+        }
+
+        const double numVoiceSamples = countVoiceSamples();
+        onsen::PerfCounters perfCounters;
+        perfCounters.start();
+        for (auto _ : state)
+        {
+            render();
+        }
+        perfCounters.stop();
+        const double numIterations = static_cast<double> (state.iterations());
+        perfCounters.report (state, numIterations * NUM_SAMPLE, numIterations * numVoiceSamples);
+    }
+
+    void setOversamplingFactor (int factor)
+    {
+        synthEngine.setOversamplingFactor (factor);
+    }
+
+    // Modulate all the destinations at control rate
+    void setControlRate()
+    {
+        pitchModControlRate = 1.0f;
+        filterModControlRate = 1.0f;
+        shapeModControlRate = 1.0f;
+        synthParams.modulation()->parameterChanged();
+    }
+
+    // A patch with only the saw and no shape
+    void setSawOnly()
+    {
+        sinGain = 0.0f;
+        squareGain = 0.0f;
+        subSquareGain = 0.0f;
+        noiseGain = 0.0f;
+        shape = 0.0f;
+        lfoShape = 0.0f;
+        envShape = 0.5f;
+        synthParams.oscillator()->parameterChanged();
+        synthParams.lfo()->parameterChanged();
+        synthParams.modulation()->parameterChanged();
+        synthParams.compileModulationMatrix();
+    }
+
+    void setSoftClip()
+    {
+        softClipOn = 1.0f;
+        synthParams.master()->parameterChanged();
+    }
+
+    // `numVoices` detuned copies spread over the stereo field
+    void setUnison (int numVoices)
+    {
+        unisonVoices = static_cast<flnum> (numVoices - 1) / (onsen::UnisonParams::maxNumVoices - 1);
+        unisonDetune = 0.5f;
+        unisonSpread = 1.0f;
+        synthParams.unison()->parameterChanged();
+    }
+
+    // `numVoices` voices which all hold a note over the whole block
+    void setChord (int numVoices)
+    {
+        synthEngine.changeNumberOfVoices (numVoices);
+        inputMidiBuffer.clear();
+        for (int i = 0; i < numVoices; ++i)
+        {
+            inputMidiBuffer.addEvent (juce::MidiMessage (NOTE_ON, C1 + i, VEL_100), 0);
+            inputMidiBuffer.addEvent (juce::MidiMessage (NOTE_ON, C1 + i, VEL_OFF), NUM_SAMPLE - 1);
+        }
+    }
+
+    // Set the depth of all the modulation routes. 0 turns off all of them.
+    void setAllModulationDepths (flnum depth)
+    {
+        pitch = depth;
+        filterFreq = depth;
+        lfoShape = depth;
+        // 0.5 is no modulation for the envelope
+        filterEnvelope = 0.5f + depth / 2;
+        envPitch = 0.5f + depth / 2;
+        envShape = 0.5f + depth / 2;
+        synthParams.lfo()->parameterChanged();
+        synthParams.filter()->parameterChanged();
+        synthParams.modulation()->parameterChanged();
+        synthParams.compileModulationMatrix();
+    }
+
     //==============================================================================
 private:
     // Private member variables
     onsen::SynthParams synthParams;
     onsen::PositionInfoMock positionInfo;
-    onsen::SynthEngine synthEngine;
+    onsen::SynthEngine<SampleType> synthEngine;
 
     std::atomic<flnum> sinGain = { 0.5f };
     std::atomic<flnum> squareGain = { 0.5f };
@@ -160,8 +281,20 @@ private:
     std::atomic<flnum> masterFineTune = { 0.5 };
     std::atomic<flnum> portamento = { 0.0f };
     std::atomic<flnum> masterVolume = { 1.0f };
+    std::atomic<flnum> softClipOn = { 0.0f };
 
-    juce::AudioBuffer<flnum> outputAudio = { NUM_CHANNEL, NUM_SAMPLE };
+    std::atomic<flnum> modControlInterval = { 0.5f };
+    std::atomic<flnum> pitchModControlRate = { 0.0f };
+    std::atomic<flnum> filterModControlRate = { 0.0f };
+    std::atomic<flnum> shapeModControlRate = { 0.0f };
+    std::atomic<flnum> envPitch = { 0.5f };
+    std::atomic<flnum> envShape = { 0.5f };
+
+    std::atomic<flnum> unisonVoices = { 0.0f };
+    std::atomic<flnum> unisonDetune = { 0.0f };
+    std::atomic<flnum> unisonSpread = { 0.0f };
+
+    juce::AudioBuffer<SampleType> outputAudio = { NUM_CHANNEL, NUM_SAMPLE };
 
     // juce::MidiMessage
     // MidiMessage (int byte1, int byte2, int byte3, double timeStamp = 0) noexcept;
@@ -190,6 +323,21 @@ private:
     //==============================================================================
     // Private method
 
+    // Samples rendered by the active voices in a render(). It renders once in
+    // small blocks and counts the active voices after each of them.
+    double countVoiceSamples()
+    {
+        constexpr int blockSize = onsen::FancySynth<SampleType>::internalBlockSize;
+        double numVoiceSamples = 0.0;
+        for (int startSample = 0; startSample < NUM_SAMPLE; startSample += blockSize)
+        {
+            const int numSamples = std::min (blockSize, NUM_SAMPLE - startSample);
+            synthEngine.renderNextBlock (outputAudio, inputMidiBuffer, startSample, numSamples);
+            numVoiceSamples += static_cast<double> (synthEngine.getNumActiveVoices()) * numSamples;
+        }
+        return numVoiceSamples;
+    }
+
     static int timeSecToSample (flnum timeSec, double sampleRate, int numSample)
     {
         int ret = static_cast<int> (timeSec * sampleRate);
@@ -198,13 +346,103 @@ private:
     }
 };
 
-BENCHMARK_F (SynthEngineFixture, render)
+BENCHMARK_TEMPLATE_F (SynthEngineFixture, render, float)
 (benchmark::State& state)
 {
-    for (auto _ : state)
-    {
-        render();
-    }
+    renderLoop (state);
+}
+
+BENCHMARK_TEMPLATE_F (SynthEngineFixture, renderDouble, double)
+(benchmark::State& state)
+{
+    renderLoop (state);
+}
+
+BENCHMARK_TEMPLATE_F (SynthEngineFixture, render2xOversampling, float)
+(benchmark::State& state)
+{
+    setOversamplingFactor (2);
+    renderLoop (state);
+}
+
+BENCHMARK_TEMPLATE_F (SynthEngineFixture, render4xOversampling, float)
+(benchmark::State& state)
+{
+    setOversamplingFactor (4);
+    renderLoop (state);
 }
 
+BENCHMARK_TEMPLATE_F (SynthEngineFixture, renderControlRate, float)
+(benchmark::State& state)
+{
+    setControlRate();
+    renderLoop (state);
+}
+
+// Unused modulation routes should cost nothing
+BENCHMARK_TEMPLATE_F (SynthEngineFixture, renderWithoutModulation, float)
+(benchmark::State& state)
+{
+    setAllModulationDepths (0.0f);
+    renderLoop (state);
+}
+
+BENCHMARK_TEMPLATE_F (SynthEngineFixture, renderAllModulationRoutes, float)
+(benchmark::State& state)
+{
+    setAllModulationDepths (0.5f);
+    renderLoop (state);
+}
+
+// Only the kernel of the saw runs
+BENCHMARK_TEMPLATE_F (SynthEngineFixture, renderSawOnly, float)
+(benchmark::State& state)
+{
+    setSawOnly();
+    renderLoop (state);
+}
+
+BENCHMARK_TEMPLATE_F (SynthEngineFixture, renderSoftClip, float)
+(benchmark::State& state)
+{
+    setSoftClip();
+    renderLoop (state);
+}
+
+// A stack of detuned copies should cost much less than the same number of voices
+BENCHMARK_TEMPLATE_DEFINE_F (SynthEngineFixture, renderUnison, float)
+(benchmark::State& state)
+{
+    setUnison (static_cast<int> (state.range (0)));
+    renderLoop (state);
+}
+BENCHMARK_REGISTER_F (SynthEngineFixture, renderUnison)->Arg (1)->Arg (4)->Arg (8);
+
+// The state of many voices is walked every sample. It shows the cost of
+// their memory layout.
+BENCHMARK_TEMPLATE_DEFINE_F (SynthEngineFixture, renderManyVoices, float)
+(benchmark::State& state)
+{
+    setChord (static_cast<int> (state.range (0)));
+    renderLoop (state);
+}
+BENCHMARK_REGISTER_F (SynthEngineFixture, renderManyVoices)->Arg (4)->Arg (12)->Arg (24);
+
+#if OS251_TRACE
+// Run the benchmarks and write the recorded trace markers to
+// $OS251_TRACE_FILE (os251_trace.json by default).
+int main (int argc, char** argv)
+{
+    benchmark::Initialize (&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments (argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+
+    const char* traceFile = std::getenv ("OS251_TRACE_FILE");
+    std::ofstream ofs (traceFile != nullptr ? traceFile : "os251_trace.json");
+    onsen::Tracer::getInstance().writeChromeTrace (ofs);
+    return 0;
+}
+#else
 BENCHMARK_MAIN();
+#endif
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+    Benchmark for memory of plugin instances
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#if JUCE_LINUX
+#include <unistd.h>
+#elif JUCE_MAC
+#include <mach/mach.h>
+#endif
+
+#include "../src/services/PresetManager.h"
+#include "../src/services/TmpFileManager.h"
+#include "../src/synth/SynthEngine.h"
+#include "../src/views/GlobalLookAndFeel.h"
+#include "../tests/dsp/util/PositionInfoMock.h"
+#include "../tests/services/AudioProcessorStateMock.h"
+
+namespace
+{
+//==============================================================================
+// Resident set size of this process. 0 if it's not supported.
+size_t getResidentBytes()
+{
+#if JUCE_LINUX
+    long numPages = 0;
+    long numResidentPages = 0;
+    if (std::FILE* file = std::fopen ("/proc/self/statm", "r"))
+    {
+        if (std::fscanf (file, "%ld %ld", &numPages, &numResidentPages) != 2)
+            numResidentPages = 0;
+        std::fclose (file);
+    }
+    return static_cast<size_t> (numResidentPages) * static_cast<size_t> (sysconf (_SC_PAGESIZE));
+#elif JUCE_MAC
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info (mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t> (&info), &count) != KERN_SUCCESS)
+        return 0;
+    return info.resident_size;
+#else
+    return 0;
+#endif
+}
+
+//==============================================================================
+// What Os251AudioProcessor allocates for each instance
+struct Instance
+{
+    Instance (const juce::File& presetDir)
+        : synthParams(),
+          positionInfo(),
+          synthEngine (&synthParams, &positionInfo),
+          processorState(),
+          presetManager (&processorState, presetDir),
+          laf()
+    {
+        presetManager.loadEmbeddedDefaultPreset();
+    }
+
+    onsen::SynthParams synthParams;
+    onsen::PositionInfoMock positionInfo;
+    // Only the engine of the host's precision is built
+    onsen::SynthEngine<float> synthEngine;
+    onsen::AudioProcessorStateMock processorState;
+    onsen::PresetManager presetManager;
+    juce::SharedResourcePointer<onsen::GlobalLookAndFeel> laf;
+};
+} // namespace
+
+//==============================================================================
+// Compare the result of 1 and 32 instances to see what is shared.
+// It runs only once because the freed memory isn't always returned to the OS.
+static void instanceMemory (benchmark::State& state)
+{
+    // The look and feel needs it
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const auto presetDir = onsen::TmpFileManager::getTmpDir().getChildFile ("benchmark_presets");
+    const int numInstances = static_cast<int> (state.range (0));
+
+    for (auto _ : state)
+    {
+        std::vector<std::unique_ptr<Instance>> instances;
+        instances.reserve (numInstances);
+        const auto residentBytesBefore = getResidentBytes();
+        for (int i = 0; i < numInstances; ++i)
+            instances.push_back (std::make_unique<Instance> (presetDir));
+        const auto residentBytesAfter = getResidentBytes();
+
+        state.counters["residentBytesPerInstance"] =
+            (static_cast<double> (residentBytesAfter) - static_cast<double> (residentBytesBefore)) / numInstances;
+    }
+}
+
+BENCHMARK (instanceMemory)->Arg (1)->Arg (32)->Iterations (1);
@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+    Hardware performance counters for the benchmarks
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if JUCE_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace onsen
+{
+//==============================================================================
+// Counts the CPU events of this thread with perf_event_open while it's
+// running, so that a benchmark can tell whether a change helped because of
+// the compute or the memory.
+// It's on when $OS251_PERF_COUNTERS is set to 1. The counters which the CPU
+// or the kernel (see /proc/sys/kernel/perf_event_paranoid) doesn't allow are
+// skipped, and on the other platforms it does nothing.
+class PerfCounters
+{
+public:
+    PerfCounters()
+    {
+        fds.fill (-1);
+#if JUCE_LINUX
+        if (! isRequested())
+            return;
+
+        for (size_t i = 0; i < events.size(); ++i)
+            fds[i] = open (events[i].type, events[i].config);
+#endif
+    }
+
+    ~PerfCounters()
+    {
+#if JUCE_LINUX
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+                close (fd);
+        }
+#endif
+    }
+
+    PerfCounters (const PerfCounters&) = delete;
+    PerfCounters& operator= (const PerfCounters&) = delete;
+
+    static bool isRequested()
+    {
+        const char* value = std::getenv ("OS251_PERF_COUNTERS");
+        return value != nullptr && std::strcmp (value, "1") == 0;
+    }
+
+    void start()
+    {
+#if JUCE_LINUX
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+            {
+                ioctl (fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl (fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void stop()
+    {
+#if JUCE_LINUX
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+                ioctl (fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+#endif
+    }
+
+    // Add the counts divided by the rendered samples and by the samples
+    // rendered by each active voice to the benchmark's output.
+    // e.g. cyclesPerSample and cyclesPerVoiceSample
+    void report (benchmark::State& state, double numSamples, double numVoiceSamples)
+    {
+        for (size_t i = 0; i < events.size(); ++i)
+        {
+            double count = 0.0;
+            if (! read (fds[i], count))
+                continue;
+
+            const std::string name = events[i].name;
+            if (numSamples > 0.0)
+                state.counters[name + "PerSample"] = count / numSamples;
+            if (numVoiceSamples > 0.0)
+                state.counters[name + "PerVoiceSample"] = count / numVoiceSamples;
+        }
+    }
+
+private:
+    struct Event
+    {
+        const char* name;
+        std::uint32_t type;
+        std::uint64_t config;
+    };
+
+#if JUCE_LINUX
+    static constexpr std::uint64_t l1ReadMisses = PERF_COUNT_HW_CACHE_L1D
+                                                  | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                                  | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    static constexpr std::array<Event, 5> events { {
+        { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { "l1Misses", PERF_TYPE_HW_CACHE, l1ReadMisses },
+        { "llcMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { "branchMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    } };
+#else
+    static constexpr std::array<Event, 0> events {};
+#endif
+
+    std::array<int, events.size()> fds;
+
+#if JUCE_LINUX
+    // Only the user space of this thread
+    static int open (std::uint32_t type, std::uint64_t config)
+    {
+        perf_event_attr attr;
+        std::memset (&attr, 0, sizeof (attr));
+        attr.size = sizeof (attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int> (syscall (SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+    // The count is scaled up if the kernel multiplexed the counter
+    static bool read (int fd, double& count)
+    {
+#if JUCE_LINUX
+        if (fd < 0)
+            return false;
+
+        std::uint64_t values[3] {};
+        if (::read (fd, values, sizeof (values)) != static_cast<ssize_t> (sizeof (values)) || values[2] == 0)
+            return false;
+
+        count = static_cast<double> (values[0]) * static_cast<double> (values[1]) / static_cast<double> (values[2]);
+        return true;
+#else
+        juce::ignoreUnused (fd, count);
+        return false;
+#endif
+    }
+};
+} // namespace onsen
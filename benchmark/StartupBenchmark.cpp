@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+    Benchmark for plugin startup
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <benchmark/benchmark.h>
+
+#include "../src/services/PresetManager.h"
+#include "../src/services/TmpFileManager.h"
+#include "../tests/services/AudioProcessorStateMock.h"
+
+//==============================================================================
+// What the processor's constructor does with presets.
+// Hosts construct an instance for each track while loading a session.
+
+class StartupFixture : public benchmark::Fixture
+{
+public:
+    void SetUp (::benchmark::State&) override
+    {
+        presetDir.deleteRecursively();
+    }
+
+    void TearDown (::benchmark::State&) override
+    {
+        presetDir.deleteRecursively();
+    }
+
+protected:
+    const juce::File presetDir { onsen::TmpFileManager::getTmpDir().getChildFile ("benchmark_presets") };
+};
+
+// The default preset in the preset folder is loaded
+BENCHMARK_F (StartupFixture, loadDefaultPresetFile) (benchmark::State& state)
+{
+    {
+        onsen::AudioProcessorStateMock processorState;
+        onsen::PresetManager presetManager (&processorState, presetDir);
+        presetManager.scanPresets();
+    }
+    for (auto _ : state)
+    {
+        onsen::AudioProcessorStateMock processorState;
+        onsen::PresetManager presetManager (&processorState, presetDir);
+        presetManager.loadPreset (presetManager.getDefaultPresetFile());
+    }
+}
+
+// The default preset is restored to the preset folder on the first run
+BENCHMARK_F (StartupFixture, loadDefaultPresetFileOnFirstRun) (benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        presetDir.deleteRecursively();
+        state.ResumeTiming();
+
+        onsen::AudioProcessorStateMock processorState;
+        onsen::PresetManager presetManager (&processorState, presetDir);
+        presetManager.loadPreset (presetManager.getDefaultPresetFile());
+    }
+}
+
+BENCHMARK_F (StartupFixture, loadEmbeddedDefaultPreset) (benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        onsen::AudioProcessorStateMock processorState;
+        onsen::PresetManager presetManager (&processorState, presetDir);
+        presetManager.loadEmbeddedDefaultPreset();
+    }
+}
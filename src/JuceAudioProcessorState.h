@@ -29,6 +29,9 @@ public:
 
     void replaceState (const juce::ValueTree& newState) override
     {
+        const juce::SpinLock::ScopedLockType lock (replaceStateLock);
+        if (onStateReplacing != nullptr)
+            onStateReplacing();
         processorState.replaceState (newState);
     }
 
@@ -54,8 +57,23 @@ public:
     {
         return AudioProcessorStateUtil::getPreset (processorState.state);
     }
+    /*
+    Held while parameters are replaced. The audio thread can try to lock it
+    so as not to read parameters which are half replaced.
+    */
+    juce::SpinLock& getReplaceStateLock()
+    {
+        return replaceStateLock;
+    }
+
+    //==============================================================================
+    // Called under the replace state lock before the new state is visible,
+    // so the audio thread never reads the new parameters without knowing it
+    std::function<void()> onStateReplacing;
+
     //==============================================================================
 private:
     juce::AudioProcessorValueTreeState& processorState;
+    juce::SpinLock replaceStateLock;
 };
 } // namespace onsen
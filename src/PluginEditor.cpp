@@ -8,7 +8,6 @@
 
 #include "PluginEditor.h"
 #include "PluginProcessor.h"
-#include "services/TmpFileManager.h"
 #include "views/PresetManagerView.h"
 #include <iostream>
 
@@ -20,8 +19,10 @@ Os251AudioProcessorEditor::Os251AudioProcessorEditor (Os251AudioProcessor& proc,
       engine (std::make_shared<reactjuce::EcmascriptEngine>()),
       appRoot (engine),
       harness (std::make_unique<reactjuce::AppHarness> (appRoot)),
-      tmpUiBundlePath(),
-      dirtyParamFlags ((processor.getParameters().size()))
+      paramIds(),
+      dirtyParamFlags ((processor.getParameters().size())),
+      isAnyParamDirty (false),
+      lastCpuLoadUpdate (-1)
 {
     setUpParameters();
     harness->onBeforeAll = [this]() {
@@ -32,26 +33,28 @@ Os251AudioProcessorEditor::Os251AudioProcessorEditor (Os251AudioProcessor& proc,
         afterBundleEvaluated();
     };
 
-    harness->watch (getBundle());
-
 #if JUCE_DEBUG
+    // Hot reload the bundle built in the source tree
+    juce::File sourceDir = juce::File (OS251_SOURCE_DIR);
+    harness->watch (sourceDir.getChildFile ("jsui/build/js/main.js"));
     harness->start();
 #else
-    harness->once();
+    // Evaluate the embedded bundle without writing it to a file
+    beforeBundleEvaluated();
+    engine->evaluateInline (getBundleSource());
+    afterBundleEvaluated();
 #endif
 
-    // Delete tmp file as soon as possible
-    auto tmpUiBundle = juce::File (tmpUiBundlePath);
-    tmpUiBundle.deleteFile();
-
     addAndMakeVisible (appRoot);
 
     setSize (appWidth, appHeight);
+    audioProcessor.getCpuLoadMonitor().addViewer();
     startTimerHz (30);
 }
 
 Os251AudioProcessorEditor::~Os251AudioProcessorEditor()
 {
+    audioProcessor.getCpuLoadMonitor().removeViewer();
     for (auto& param : audioProcessor.getParameters())
     {
         param->removeListener (this);
@@ -62,6 +65,8 @@ Os251AudioProcessorEditor::~Os251AudioProcessorEditor()
 void Os251AudioProcessorEditor::parameterValueChanged (int parameterIndex, float newValue)
 {
     dirtyParamFlags[parameterIndex] = true;
+    // Set after the flag so that updateUi() never misses it
+    isAnyParamDirty = true;
 }
 
 void Os251AudioProcessorEditor::parameterGestureChanged (int, bool)
@@ -72,6 +77,7 @@ void Os251AudioProcessorEditor::parameterGestureChanged (int, bool)
 void Os251AudioProcessorEditor::timerCallback()
 {
     updateUi();
+    updateCpuLoad();
 }
 
 //==============================================================================
@@ -86,25 +92,11 @@ void Os251AudioProcessorEditor::paint (juce::Graphics& g)
 }
 
 //==============================================================================
-juce::File Os251AudioProcessorEditor::getBundle()
+const juce::String& Os251AudioProcessorEditor::getBundleSource()
 {
-    const juce::File dir = onsen::TmpFileManager::getTmpDir();
-    const juce::String jsFileName = "main.js";
-    juce::File bundle = onsen::TmpFileManager::createTempFile (dir, jsFileName);
-    tmpUiBundlePath = bundle.getFullPathName(); // It should be deleted on the caller
-
-    {
-        dir.createDirectory();
-        juce::FileOutputStream fs = juce::FileOutputStream (bundle);
-        fs.write (BinaryData::main_js, BinaryData::main_jsSize);
-        fs.flush();
-    }
-
-#if JUCE_DEBUG
-    juce::File sourceDir = juce::File (OS251_SOURCE_DIR);
-    bundle = sourceDir.getChildFile ("jsui/build/js/main.js");
-#endif
-    return bundle;
+    // Decoded once and shared by the editors of all instances
+    static const juce::String source = juce::String::fromUTF8 (BinaryData::main_js, BinaryData::main_jsSize);
+    return source;
 }
 
 void Os251AudioProcessorEditor::setUpParameters()
@@ -116,37 +108,60 @@ void Os251AudioProcessorEditor::setUpParameters()
         auto paramWithId = dynamic_cast<juce::AudioProcessorParameterWithID*> (param);
         assert (paramWithId);
         parameterById[paramWithId->paramID] = param;
+        paramIds.push_back (paramWithId->paramID);
+        jassert (param->getParameterIndex() == static_cast<int> (paramIds.size()) - 1);
         dirtyParamFlags[param->getParameterIndex()] = true;
         param->addListener (this);
     }
+    isAnyParamDirty = true;
 }
 void Os251AudioProcessorEditor::updateUi()
 {
+    if (! isAnyParamDirty.exchange (false))
+    {
+        return;
+    }
+
+    // All changes in a frame are sent to JS with one event
+    const auto& params = audioProcessor.getParameters();
+    juce::Array<juce::var> changes;
     for (int i = 0; i < dirtyParamFlags.size(); ++i)
     {
-        if (dirtyParamFlags[i])
+        if (dirtyParamFlags[i].exchange (false))
         {
-            dirtyParamFlags[i] = false;
-
-            const auto& param = audioProcessor.getParameters()[i];
-
-            auto* paramWithId = dynamic_cast<juce::AudioProcessorParameterWithID*> (param);
-            assert (paramWithId);
-            juce::String paramId = paramWithId->paramID;
-
-            float defaultValue = param->getDefaultValue();
+            const auto* param = params[i];
             const float value = param->getValue();
-            juce::String stringValue = param->getText (value, 0);
-
-            appRoot.dispatchEvent (
-                "parameterValueChange",
+            changes.add (juce::Array<juce::var> {
                 i,
-                paramId,
-                defaultValue,
+                paramIds[i],
+                param->getDefaultValue(),
                 value,
-                stringValue);
+                param->getText (value, 0) });
         }
     }
+
+    if (! changes.isEmpty())
+    {
+        appRoot.dispatchEvent ("parameterValuesChange", changes);
+    }
+}
+
+void Os251AudioProcessorEditor::updateCpuLoad()
+{
+    const auto& monitor = audioProcessor.getCpuLoadMonitor();
+    if (monitor.getNumUpdates() == lastCpuLoadUpdate)
+    {
+        return;
+    }
+    lastCpuLoadUpdate = monitor.getNumUpdates();
+
+    const auto& stats = monitor.getStats();
+    appRoot.dispatchEvent (
+        "cpuLoadChange",
+        stats.averageLoad * 100.0,
+        stats.peakLoad * 100.0,
+        stats.numActiveVoices,
+        stats.numXrunRisks);
 }
 
 void Os251AudioProcessorEditor::beforeBundleEvaluated()
@@ -201,4 +216,6 @@ void Os251AudioProcessorEditor::afterBundleEvaluated()
     {
         parameterValueChanged (param->getParameterIndex(), param->getValue());
     }
+    // Send the latest stats to the new bundle
+    lastCpuLoadUpdate = -1;
 }
@@ -35,9 +35,10 @@ public:
     void timerCallback() override;
 
 private:
-    juce::File getBundle();
+    static const juce::String& getBundleSource();
     void setUpParameters();
     void updateUi();
+    void updateCpuLoad();
     void beforeBundleEvaluated();
     void afterBundleEvaluated();
     //==============================================================================
@@ -48,10 +49,13 @@ private:
     std::shared_ptr<reactjuce::EcmascriptEngine> engine;
     reactjuce::ReactApplicationRoot appRoot;
     std::unique_ptr<reactjuce::AppHarness> harness;
-    juce::String tmpUiBundlePath;
 
     std::unordered_map<juce::String, juce::AudioProcessorParameter*> parameterById;
+    // By parameter index
+    std::vector<juce::String> paramIds;
     std::vector<std::atomic<bool>> dirtyParamFlags;
+    std::atomic<bool> isAnyParamDirty;
+    int lastCpuLoadUpdate;
 
     static constexpr int bodyWidth = 758;
     static constexpr int bodyHeight = 420;
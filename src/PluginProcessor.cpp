@@ -8,7 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include "services/TmpFileManager.h"
+#include "services/Trace.h"
 
 //==============================================================================
 Os251AudioProcessor::Os251AudioProcessor()
@@ -26,14 +26,20 @@ Os251AudioProcessor::Os251AudioProcessor()
       synthParams(),
       positionInfo(),
       jucePositionInfo (&positionInfo),
-      synthEngine (&synthParams, &jucePositionInfo),
+      synthEngine(),
+      synthEngineDouble(),
       processorState (parameters),
       presetManager (
           &processorState,
           juce::File::getSpecialLocation (
               juce::File::SpecialLocationType::userApplicationDataDirectory)
               .getChildFile ("Onsen Audio/OS-251/presets")),
-      laf()
+      laf(),
+      cpuLoadMeter(),
+      cpuLoadMonitor (&cpuLoadMeter, onsen::CpuLoadMonitor::getCsvFileFromEnvironment()),
+      paramsChanged (true),
+      presetChanged (false),
+      presetFadeSamples (static_cast<int> (onsen::DEFAULT_SAMPLE_RATE * presetFadeTimeSec))
 {
     // ---
     // Parameter value conversion from [0, 1.0] float to juce::String.
@@ -76,6 +82,23 @@ Os251AudioProcessor::Os251AudioProcessor()
     auto numVoicesToStr = [] (float value) { return juce::String (
                                                  onsen::DspUtil::mapFlnumToInt (
                                                      value, 0.0, 1.0, 1, onsen::MasterParams::maxNumVoices)); };
+
+    // Oversampling factor
+    auto oversamplingToStr = [] (float value) { return juce::String (
+                                                    1 << onsen::DspUtil::mapFlnumToInt (
+                                                        value, 0.0, 1.0, 0, onsen::MasterParams::maxOversamplingFactorLog2))
+                                                + juce::String ("x"); };
+
+    // Number of unison voices
+    auto unisonVoicesToStr = [] (float value) { return juce::String (
+                                                    onsen::DspUtil::mapFlnumToInt (
+                                                        value, 0.0, 1.0, 1, onsen::UnisonParams::maxNumVoices)); };
+
+    // Control interval of the modulations
+    auto controlIntervalToStr = [] (float value) { return juce::String (
+                                                       1 << onsen::DspUtil::mapFlnumToInt (
+                                                           value, 0.0, 1.0, onsen::ModulationParams::minControlIntervalLog2, onsen::ModulationParams::maxControlIntervalLog2))
+                                                   + juce::String (" samples"); };
     // ---
 
     // ---
@@ -116,6 +139,24 @@ Os251AudioProcessor::Os251AudioProcessor()
     oscillatorParams->setShapePtr (parameters.getRawParameterValue ("shape"));
     parameters.addParameterListener ("shape", this);
 
+    // Unison parameters
+    onsen::UnisonParams* const unisonParams = synthParams.unison();
+
+    // Number of detuned copies of the oscillator
+    parameters.createAndAddParameter (std::make_unique<Parameter> ("unisonVoices", "Unison Voices", "", nrange, 0.0, unisonVoicesToStr, nullptr, true));
+    unisonParams->setNumVoicesPtr (parameters.getRawParameterValue ("unisonVoices"));
+    parameters.addParameterListener ("unisonVoices", this);
+
+    // Detune
+    parameters.createAndAddParameter (std::make_unique<Parameter> ("unisonDetune", "Unison Detune", "", nrange, 0.3, valueToTextFunction, nullptr, true));
+    unisonParams->setDetunePtr (parameters.getRawParameterValue ("unisonDetune"));
+    parameters.addParameterListener ("unisonDetune", this);
+
+    // Stereo spread
+    parameters.createAndAddParameter (std::make_unique<Parameter> ("unisonSpread", "Unison Spread", "", nrange, 0.5, valueToTextFunction, nullptr, true));
+    unisonParams->setSpreadPtr (parameters.getRawParameterValue ("unisonSpread"));
+    parameters.addParameterListener ("unisonSpread", this);
+
     // Envelop parameters
     onsen::EnvelopeParams* const envelopeParams = synthParams.envelope();
 
@@ -252,6 +293,44 @@ Os251AudioProcessor::Os251AudioProcessor()
     masterParams->setMasterVolumePtr (parameters.getRawParameterValue (("masterVolume")));
     parameters.addParameterListener ("masterVolume", this);
 
+    // Saturate with tanh instead of clipping hard
+    parameters.createAndAddParameter (std::make_unique<Parameter> ("softClipOn", "Soft Clip", "", nrange, 0.0, valueToOnOff, nullptr, true));
+    masterParams->setSoftClipOnPtr (parameters.getRawParameterValue ("softClipOn"));
+    parameters.addParameterListener ("softClipOn", this);
+
+    // Modulation parameters
+    onsen::ModulationParams* const modulationParams = synthParams.modulation();
+
+    // Env -> Pitch
+    parameters.createAndAddParameter (std::make_unique<Parameter> ("envPitch", "Env -> Pitch", "", nrange, 0.5, valueToMinusOneToOneFunction, nullptr, true));
+    modulationParams->setEnvPitchPtr (parameters.getRawParameterValue ("envPitch"));
+    parameters.addParameterListener ("envPitch", this);
+
+    // Env -> Shape
+    parameters.createAndAddParameter (std::make_unique<Parameter> ("envShape", "Env -> Shape", "", nrange, 0.5, valueToMinusOneToOneFunction, nullptr, true));
+    modulationParams->setEnvShapePtr (parameters.getRawParameterValue ("envShape"));
+    parameters.addParameterListener ("envShape", this);
+
+    // Control interval
+    parameters.createAndAddParameter (std::make_unique<Parameter> ("modControlInterval", "Mod Control Interval", "", nrange, 0.5, controlIntervalToStr, nullptr, true));
+    modulationParams->setControlIntervalPtr (parameters.getRawParameterValue ("modControlInterval"));
+    parameters.addParameterListener ("modControlInterval", this);
+
+    // Modulations of pitch at control rate (ON) or audio rate (OFF)
+    parameters.createAndAddParameter (std::make_unique<Parameter> ("pitchModControlRate", "Pitch Mod Control Rate", "", nrange, 0.0, valueToOnOff, nullptr, true));
+    modulationParams->setPitchControlRatePtr (parameters.getRawParameterValue ("pitchModControlRate"));
+    parameters.addParameterListener ("pitchModControlRate", this);
+
+    // Modulations of filter frequency at control rate (ON) or audio rate (OFF)
+    parameters.createAndAddParameter (std::make_unique<Parameter> ("filterModControlRate", "Filter Mod Control Rate", "", nrange, 0.0, valueToOnOff, nullptr, true));
+    modulationParams->setFilterControlRatePtr (parameters.getRawParameterValue ("filterModControlRate"));
+    parameters.addParameterListener ("filterModControlRate", this);
+
+    // Modulations of shape at control rate (ON) or audio rate (OFF)
+    parameters.createAndAddParameter (std::make_unique<Parameter> ("shapeModControlRate", "Shape Mod Control Rate", "", nrange, 0.0, valueToOnOff, nullptr, true));
+    modulationParams->setShapeControlRatePtr (parameters.getRawParameterValue ("shapeModControlRate"));
+    parameters.addParameterListener ("shapeModControlRate", this);
+
     // ---
 
     // Parameters used with callback
@@ -262,21 +341,26 @@ Os251AudioProcessor::Os251AudioProcessor()
     parameters.createAndAddParameter (std::make_unique<Parameter> ("numVoices", "Num Voices", "", nrange, defaultFlnumNumVoices, numVoicesToStr, nullptr, true));
     parameters.addParameterListener ("numVoices", this);
 
+    // Oversampling of the voices (1x, 2x or 4x)
+    parameters.createAndAddParameter (std::make_unique<Parameter> ("oversampling", "Oversampling", "", nrange, 0.0, oversamplingToStr, nullptr, true));
+    parameters.addParameterListener ("oversampling", this);
+
     parameters.state = juce::ValueTree (juce::Identifier ("OS-251"));
+    setUpParameterIdHashes();
+    processorState.onStateReplacing = [this] { presetChanged = true; };
 
     // Preset management
     juce::ValueTree preset (juce::Identifier ("CurrentPreset"));
     preset.setProperty (juce::Identifier ("path"), "Default.oapreset", nullptr);
     parameters.state.addChild (preset, 0, nullptr);
 
-    // Try to load default preset file so that users can
-    // have their own default preset.
-    presetManager.loadPreset (presetManager.getDefaultPresetFile());
+    // Hosts construct many instances while loading a session, so the preset
+    // folder is restored and scanned later when the preset menu is used.
+    presetManager.loadEmbeddedDefaultPreset();
 }
 
 Os251AudioProcessor::~Os251AudioProcessor()
 {
-    onsen::TmpFileManager::cleanUpTmpDir (onsen::TmpFileManager::getTmpDir());
 }
 
 //==============================================================================
@@ -346,15 +430,73 @@ void Os251AudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
-    synthEngine.prepareToPlay (samplesPerBlock, sampleRate);
+    OS251_TRACE_PREPARE();
+    {
+        const juce::ScopedLock sl (engineLock);
+        if (isUsingDoublePrecision())
+        {
+            prepareEngine (synthEngineDouble, sampleRate, samplesPerBlock);
+            synthEngine.reset();
+        }
+        else
+        {
+            prepareEngine (synthEngine, sampleRate, samplesPerBlock);
+            synthEngineDouble.reset();
+        }
+    }
     synthParams.prepareToPlay (samplesPerBlock, sampleRate);
+    cpuLoadMeter.prepareToPlay (sampleRate);
+    presetFadeSamples = std::max (1, static_cast<int> (sampleRate * presetFadeTimeSec));
+    paramsChanged = false;
+    updateParams();
+    setLatencySamples (getEngineLatencySamples());
+}
+
+template <typename SampleType>
+void Os251AudioProcessor::prepareEngine (std::unique_ptr<onsen::SynthEngine<SampleType>>& engine,
+                                         double sampleRate,
+                                         int samplesPerBlock)
+{
+    if (! engine)
+    {
+        // The parameters may have changed while the engine didn't exist
+        engine = std::make_unique<onsen::SynthEngine<SampleType>> (&synthParams, &jucePositionInfo);
+        engine->changeNumberOfVoices (getNumVoicesParam());
+        engine->setOversamplingFactor (getOversamplingFactorParam());
+    }
+    engine->prepareToPlay (samplesPerBlock, sampleRate);
+}
+
+int Os251AudioProcessor::getNumVoicesParam() const
+{
+    const float value = parameters.getRawParameterValue ("numVoices")->load();
+    return onsen::DspUtil::mapFlnumToInt (value, 0.0, 1.0, 1, onsen::MasterParams::maxNumVoices);
+}
+
+int Os251AudioProcessor::getOversamplingFactorParam() const
+{
+    const float value = parameters.getRawParameterValue ("oversampling")->load();
+    return 1 << onsen::DspUtil::mapFlnumToInt (value, 0.0, 1.0, 0, onsen::MasterParams::maxOversamplingFactorLog2);
+}
+
+int Os251AudioProcessor::getEngineLatencySamples() const
+{
+    if (synthEngine)
+        return synthEngine->getLatencySamples();
+    if (synthEngineDouble)
+        return synthEngineDouble->getLatencySamples();
+    return 0;
 }
 
 void Os251AudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
-    synthEngine.releaseResources();
+    const juce::ScopedLock sl (engineLock);
+    if (synthEngine)
+        synthEngine->releaseResources();
+    if (synthEngineDouble)
+        synthEngineDouble->releaseResources();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -383,6 +525,29 @@ bool Os251AudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
 
 void Os251AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    jassert (synthEngine != nullptr);
+    processBlockWithEngine (buffer, midiMessages, *synthEngine);
+}
+
+void Os251AudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    // The host runs in double precision. Render natively to avoid converting the buffer.
+    jassert (synthEngineDouble != nullptr);
+    processBlockWithEngine (buffer, midiMessages, *synthEngineDouble);
+}
+
+bool Os251AudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void Os251AudioProcessor::processBlockWithEngine (juce::AudioBuffer<SampleType>& buffer,
+                                                  juce::MidiBuffer& midiMessages,
+                                                  onsen::SynthEngine<SampleType>& engine)
+{
+    const auto startTime = cpuLoadMeter.start();
+
     // Host inforrmation
     auto playHead = getPlayHead();
     if (playHead)
@@ -419,7 +584,32 @@ void Os251AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::
         buffer.clear (channel, 0, buffer.getNumSamples());
     }
 
-    synthEngine.renderNextBlock (buffer, midiMessages, 0, buffer.getNumSamples());
+    const int numSamples = buffer.getNumSamples();
+    int startSample = 0;
+    bool isPresetChanged = false;
+    {
+        // The flag is set before the state is replaced. Take it after the
+        // replacement so that the fade in uses the new parameters.
+        const juce::SpinLock::ScopedTryLockType lock (processorState.getReplaceStateLock());
+        if (lock.isLocked())
+            isPresetChanged = presetChanged.exchange (false);
+    }
+    if (isPresetChanged)
+    {
+        // Fade out with the previous parameters
+        startSample = std::min (numSamples / 2, presetFadeSamples);
+        engine.renderNextBlock (buffer, midiMessages, 0, startSample);
+        buffer.applyGainRamp (0, startSample, 1.0, 0.0);
+    }
+
+    if (paramsChanged.exchange (false) && ! tryToUpdateParams())
+        paramsChanged = true; // Retry in the next block
+
+    engine.renderNextBlock (buffer, midiMessages, startSample, numSamples - startSample);
+    if (isPresetChanged)
+        buffer.applyGainRamp (startSample, std::min (numSamples - startSample, presetFadeSamples), 0.0, 1.0);
+
+    cpuLoadMeter.stop (startTime, buffer.getNumSamples(), engine.getNumActiveVoices());
 }
 
 //==============================================================================
@@ -428,10 +618,15 @@ bool Os251AudioProcessor::hasEditor() const
     return true; // (change this to false if you choose to not supply an editor)
 }
 
+onsen::CpuLoadMonitor& Os251AudioProcessor::getCpuLoadMonitor()
+{
+    return cpuLoadMonitor;
+}
+
 juce::AudioProcessorEditor* Os251AudioProcessor::createEditor()
 {
     // Look and feel
-    juce::LookAndFeel::setDefaultLookAndFeel (&laf);
+    juce::LookAndFeel::setDefaultLookAndFeel (&laf.get());
     return new Os251AudioProcessorEditor (*this, parameters, presetManager);
 }
 
@@ -442,9 +637,21 @@ void Os251AudioProcessor::getStateInformation (juce::MemoryBlock& destData)
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
 
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    // Write raw parameter values without building XML.
+    // See onsen::BinaryState for the format.
+    onsen::BinaryState::State state;
+    state.params.reserve (getParameters().size());
+    for (auto* param : getParameters())
+    {
+        auto* paramWithId = dynamic_cast<juce::AudioProcessorParameterWithID*> (param);
+        assert (paramWithId);
+        state.params.emplace_back (onsen::BinaryState::hashParameterId (paramWithId->paramID.toRawUTF8()), param->getValue());
+    }
+    state.presetPath = onsen::AudioProcessorStateUtil::getPreset (parameters.state).toStdString();
+
+    std::vector<uint8_t> bytes;
+    onsen::BinaryState::write (state, bytes);
+    destData.replaceWith (bytes.data(), bytes.size());
 }
 
 void Os251AudioProcessor::setStateInformation (const void* data, int sizeInBytes)
@@ -452,38 +659,107 @@ void Os251AudioProcessor::setStateInformation (const void* data, int sizeInBytes
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
 
+    if (! onsen::BinaryState::isBinaryState (data, static_cast<size_t> (sizeInBytes)))
+    {
+        // Written by older versions
+        setXmlStateInformation (data, sizeInBytes);
+        return;
+    }
+
+    onsen::BinaryState::State state;
+    if (! onsen::BinaryState::read (data, static_cast<size_t> (sizeInBytes), state))
+        return;
+
+    {
+        const juce::SpinLock::ScopedLockType lock (processorState.getReplaceStateLock());
+        for (const auto& [hash, value] : state.params)
+        {
+            auto it = parameterByIdHash.find (hash);
+            if (it != parameterByIdHash.end() && it->second->getValue() != value)
+                it->second->setValueNotifyingHost (value);
+        }
+    }
+    onsen::AudioProcessorStateUtil::setPreset (parameters.state, juce::String::fromUTF8 (state.presetPath.data(), static_cast<int> (state.presetPath.size())));
+    presetManager.requireToUpdatePresetNameOnUI();
+}
+
+void Os251AudioProcessor::setXmlStateInformation (const void* data, int sizeInBytes)
+{
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
 
     if (xmlState.get() != nullptr)
         if (xmlState->hasTagName (parameters.state.getType()))
         {
-            parameters.replaceState (juce::ValueTree::fromXml (*xmlState));
+            processorState.replaceState (juce::ValueTree::fromXml (*xmlState));
             presetManager.requireToUpdatePresetNameOnUI();
         }
 }
 
+void Os251AudioProcessor::setUpParameterIdHashes()
+{
+    for (auto* param : getParameters())
+    {
+        auto* paramWithId = dynamic_cast<juce::AudioProcessorParameterWithID*> (param);
+        assert (paramWithId);
+        const auto hash = onsen::BinaryState::hashParameterId (paramWithId->paramID.toRawUTF8());
+        // Hash collision. Rename one of the parameters.
+        jassert (parameterByIdHash.find (hash) == parameterByIdHash.end());
+        parameterByIdHash[hash] = param;
+    }
+}
+
+void Os251AudioProcessor::updateParams()
+{
+    synthParams.oscillator()->parameterChanged();
+    synthParams.envelope()->parameterChanged();
+    synthParams.lfo()->parameterChanged();
+    synthParams.filter()->parameterChanged();
+    synthParams.chorus()->parameterChanged();
+    synthParams.hpf()->parameterChanged();
+    synthParams.master()->parameterChanged();
+    synthParams.modulation()->parameterChanged();
+    synthParams.unison()->parameterChanged();
+    synthParams.compileModulationMatrix();
+}
+
+bool Os251AudioProcessor::tryToUpdateParams()
+{
+    // Don't wait for the message thread replacing the state.
+    // Keep the current parameters until all of them are replaced.
+    const juce::SpinLock::ScopedTryLockType lock (processorState.getReplaceStateLock());
+    if (! lock.isLocked())
+        return false;
+
+    updateParams();
+    return true;
+}
+
 void Os251AudioProcessor::parameterChanged (const juce::String& parameterID, float newValue)
 {
-    // TODO: Update parameters in an efficient way
-    onsen::OscillatorParams* const oscillatorParams = synthParams.oscillator();
-    onsen::EnvelopeParams* const envelopeParams = synthParams.envelope();
-    onsen::LfoParams* const lfoParams = synthParams.lfo();
-    onsen::FilterParams* const filterParams = synthParams.filter();
-    onsen::ChorusParams* const chorusParams = synthParams.chorus();
-    onsen::HpfParams* const hpfParams = synthParams.hpf();
-    onsen::MasterParams* const master = synthParams.master();
-    oscillatorParams->parameterChanged();
-    envelopeParams->parameterChanged();
-    lfoParams->parameterChanged();
-    filterParams->parameterChanged();
-    chorusParams->parameterChanged();
-    hpfParams->parameterChanged();
-    master->parameterChanged();
+    // Loading a preset changes all the parameters,
+    // so synthParams is updated only once in the next block.
+    paramsChanged = true;
 
     if (parameterID == "numVoices")
     {
         const int num = onsen::DspUtil::mapFlnumToInt (newValue, 0.0, 1.0, 1, onsen::MasterParams::maxNumVoices);
-        synthEngine.changeNumberOfVoices (num);
+        const juce::ScopedLock sl (engineLock);
+        if (synthEngine)
+            synthEngine->changeNumberOfVoices (num);
+        if (synthEngineDouble)
+            synthEngineDouble->changeNumberOfVoices (num);
+    }
+
+    if (parameterID == "oversampling")
+    {
+        const int factor = 1 << onsen::DspUtil::mapFlnumToInt (newValue, 0.0, 1.0, 0, onsen::MasterParams::maxOversamplingFactorLog2);
+        const juce::ScopedLock sl (engineLock);
+        if (synthEngine)
+            synthEngine->setOversamplingFactor (factor);
+        if (synthEngineDouble)
+            synthEngineDouble->setOversamplingFactor (factor);
+        // The host compensates the delay of the decimation
+        setLatencySamples (getEngineLatencySamples());
     }
 }
 
@@ -10,10 +10,15 @@
 
 #include "JuceAudioProcessorState.h"
 #include "dsp/JucePositionInfo.h"
+#include "services/BinaryState.h"
+#include "services/CpuLoadMonitor.h"
 #include "services/PresetManager.h"
 #include "synth/SynthEngine.h"
 #include "views/GlobalLookAndFeel.h"
 #include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
 
 //==============================================================================
 /**
@@ -34,6 +39,8 @@ public:
 #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -58,19 +65,55 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    //==============================================================================
+    onsen::CpuLoadMonitor& getCpuLoadMonitor();
+
 private:
     //==============================================================================
     juce::AudioProcessorValueTreeState parameters;
     onsen::SynthParams synthParams;
     juce::AudioPlayHead::CurrentPositionInfo positionInfo;
     onsen::JucePositionInfo jucePositionInfo;
-    onsen::SynthEngine synthEngine;
+    // Only the engine of the host's precision exists. prepareToPlay() builds
+    // it and frees the other one.
+    std::unique_ptr<onsen::SynthEngine<float>> synthEngine;
+    std::unique_ptr<onsen::SynthEngine<double>> synthEngineDouble;
+    // parameterChanged() can run on any thread while prepareToPlay() swaps the engines
+    juce::CriticalSection engineLock;
     onsen::JuceAudioProcessorState processorState;
     onsen::PresetManager presetManager;
-    onsen::GlobalLookAndFeel laf;
+    // Shared by all instances because it loads the font
+    juce::SharedResourcePointer<onsen::GlobalLookAndFeel> laf;
+    onsen::CpuLoadMeter cpuLoadMeter;
+    onsen::CpuLoadMonitor cpuLoadMonitor;
+    // For the binary state. See onsen::BinaryState.
+    std::unordered_map<uint32_t, juce::AudioProcessorParameter*> parameterByIdHash;
+    // Parameters are copied to synthParams at the start of a block, not in parameterChanged().
+    std::atomic<bool> paramsChanged;
+    // The block after a preset is loaded fades out with the previous parameters
+    // and fades in with the new ones.
+    std::atomic<bool> presetChanged;
+    static constexpr double presetFadeTimeSec = 0.005;
+    int presetFadeSamples;
 
     //==============================================================================
+    template <typename SampleType>
+    void processBlockWithEngine (juce::AudioBuffer<SampleType>& buffer,
+                                 juce::MidiBuffer& midiMessages,
+                                 onsen::SynthEngine<SampleType>& engine);
+    template <typename SampleType>
+    void prepareEngine (std::unique_ptr<onsen::SynthEngine<SampleType>>& engine,
+                        double sampleRate,
+                        int samplesPerBlock);
+    int getNumVoicesParam() const;
+    int getOversamplingFactorParam() const;
+    // 0 until prepareToPlay() builds an engine
+    int getEngineLatencySamples() const;
     void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void setUpParameterIdHashes();
+    void updateParams();
+    bool tryToUpdateParams();
+    void setXmlStateInformation (const void* data, int sizeInBytes);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Os251AudioProcessor)
 };
@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+   Buffer arena
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DspCommon.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace onsen
+{
+//==============================================================================
+// Contiguous buffer placed in a BufferArena. It doesn't own the memory.
+template <typename T>
+class ArenaBuffer
+{
+public:
+    T* data() { return ptr; }
+    const T* data() const { return ptr; }
+    size_t size() const { return numElements; }
+
+    T& operator[] (size_t i)
+    {
+        assert (i < numElements);
+        return ptr[i];
+    }
+
+    const T& operator[] (size_t i) const
+    {
+        assert (i < numElements);
+        return ptr[i];
+    }
+
+private:
+    friend class BufferArena;
+    T* ptr = nullptr;
+    size_t numElements = 0;
+};
+
+//==============================================================================
+// One allocation for the buffers of several DSP objects, so that an engine's
+// buffers are next to each other and allocated at once.
+// allocate() calls `placeAll` twice with a Placer: first to add up the sizes
+// of the buffers, then to hand out the parts of the new allocation. Each
+// buffer starts at a cache line, and its elements are value-initialized.
+class BufferArena
+{
+public:
+    class Placer
+    {
+    public:
+        template <typename T>
+        void place (ArenaBuffer<T>& buffer, size_t size)
+        {
+            static_assert (std::is_trivially_destructible_v<T>);
+            static_assert (alignof (T) <= CACHE_LINE_SIZE);
+            if (storage != nullptr)
+            {
+                buffer.ptr = reinterpret_cast<T*> (storage + offset);
+                buffer.numElements = size;
+                std::uninitialized_value_construct_n (buffer.ptr, size);
+            }
+            offset += roundUpToCacheLine (size * sizeof (T));
+        }
+
+    private:
+        friend class BufferArena;
+        explicit Placer (std::byte* _storage) : storage (_storage), offset (0) {}
+
+        std::byte* const storage;
+        size_t offset;
+    };
+
+    BufferArena() : storage (nullptr), numBytes (0) {}
+    ~BufferArena() { release(); }
+
+    BufferArena (const BufferArena&) = delete;
+    BufferArena& operator= (const BufferArena&) = delete;
+
+    // The buffers placed before are invalid after it
+    template <typename PlaceAll>
+    void allocate (PlaceAll&& placeAll)
+    {
+        Placer sizer (nullptr);
+        placeAll (sizer);
+        release();
+        numBytes = sizer.offset;
+        storage = static_cast<std::byte*> (::operator new (std::max (numBytes, CACHE_LINE_SIZE), std::align_val_t (CACHE_LINE_SIZE)));
+        Placer placer (storage);
+        placeAll (placer);
+    }
+
+    void release()
+    {
+        if (storage != nullptr)
+            ::operator delete (storage, std::align_val_t (CACHE_LINE_SIZE));
+        storage = nullptr;
+        numBytes = 0;
+    }
+
+    size_t getNumBytes() const
+    {
+        return numBytes;
+    }
+
+private:
+    std::byte* storage;
+    size_t numBytes;
+};
+
+//==============================================================================
+// The arena of a DSP object which can also be placed in its owner's arena.
+// The object has an arena of its own until share() is called. After that,
+// allocate() does nothing, and the owner places the object's buffers in the
+// shared arena whenever their sizes change.
+class LocalBufferArena
+{
+public:
+    LocalBufferArena() : shared (nullptr) {}
+
+    template <typename PlaceAll>
+    void allocate (PlaceAll&& placeAll)
+    {
+        if (shared == nullptr)
+            own.allocate (std::forward<PlaceAll> (placeAll));
+    }
+
+    void share (BufferArena& arena)
+    {
+        shared = &arena;
+        own.release();
+    }
+
+private:
+    BufferArena own;
+    BufferArena* shared;
+};
+} // namespace onsen
@@ -7,26 +7,29 @@
 */
 
 #include "Chorus.h"
+#include "../services/Trace.h"
 
 namespace onsen
 {
 //==============================================================================
-void Chorus::render (IAudioBuffer* outputAudio, int startSample, int numSamples)
+template <typename SampleType>
+void Chorus<SampleType>::render (IAudioBuffer<SampleType>* outputAudio, int startSample, int numSamples)
 {
+    OS251_TRACE_SCOPE ("Chorus::render");
     int idx = startSample;
     while (--numSamples >= 0)
     {
         // Convert input to mono
-        flnum monoInputVal = 0.0;
+        SampleType monoInputVal = 0.0;
         for (auto i = outputAudio->getNumChannels(); --i >= 0;)
         {
             monoInputVal += outputAudio->getSample (i, idx);
         }
         monoInputVal /= outputAudio->getNumChannels();
 
-        const flnum delayVal = getModDelayValue();
-        buf.at (writePointer) = monoInputVal + delayVal * feedback;
-        flnum outputVal = monoInputVal * dryLevel + delayVal * wetLevel;
+        const SampleType delayVal = getModDelayValue();
+        buf[writePointer] = monoInputVal + delayVal * feedback;
+        SampleType outputVal = monoInputVal * dryLevel + delayVal * wetLevel;
         for (auto i = outputAudio->getNumChannels(); --i >= 0;)
         {
             outputAudio->setSample (i, idx, outputVal);
@@ -39,17 +42,34 @@ void Chorus::render (IAudioBuffer* outputAudio, int startSample, int numSamples)
     }
 }
 
-void Chorus::setCurrentPlaybackSampleRate (double _sampleRate)
+template <typename SampleType>
+void Chorus<SampleType>::setCurrentPlaybackSampleRate (double _sampleRate)
 {
     sampleRate = _sampleRate;
     prepare();
 }
 
-void Chorus::prepare()
+template <typename SampleType>
+void Chorus<SampleType>::useBufferArena (BufferArena& arena)
 {
-    const auto bufSize = static_cast<int> (sampleRate * maxDelayTime_msec / 1000.0);
-    assert (bufSize > 0);
-    buf.resize (bufSize, 0.0);
+    bufferArena.share (arena);
+}
+
+template <typename SampleType>
+void Chorus<SampleType>::placeBuffers (BufferArena::Placer& placer)
+{
+    placer.place (buf, getBufSize());
+}
+
+template <typename SampleType>
+void Chorus<SampleType>::prepare()
+{
+    assert (getBufSize() > 0);
+    bufferArena.allocate ([this] (BufferArena::Placer& placer) { placeBuffers (placer); });
     writePointer = 0;
 }
+
+//==============================================================================
+template class Chorus<float>;
+template class Chorus<double>;
 } // namespace onsen
@@ -8,45 +8,35 @@
 
 #pragma once
 
+#include "BufferArena.h"
 #include "DspCommon.h"
 #include "IAudioBuffer.h"
-#include <vector>
+#include "Phasor.h"
 
 namespace onsen
 {
 //==============================================================================
+template <typename SampleType>
 class Chorus
 {
+    static constexpr SampleType pi = pi_v<SampleType>;
+
     struct ChorusLfo
     {
     public:
-        flnum val() const
+        SampleType val() const
         {
-            return sinWave (currentAngle);
+            return DspMath::sin (phase.radians<SampleType>());
         }
 
         void update()
         {
-            currentAngle += angleDelta();
-            if (currentAngle > 2.0 * pi)
-                currentAngle -= 2.0 * pi;
-        }
-
-    private:
-        flnum angleDelta() const
-        {
-            return 2.0 * pi * freq / sampleRate;
+            phase.advance (Phasor::toIncrement (freq / sampleRate));
         }
 
-        static flnum sinWave (flnum angle)
-        {
-            return std::sin (angle);
-        }
-
-    public:
-        flnum currentAngle;
-        flnum freq;
-        const flnum& sampleRate;
+        Phasor phase;
+        SampleType freq;
+        const SampleType& sampleRate;
     };
 
 public:
@@ -55,8 +45,10 @@ public:
           delayTime_msec (15.0),
           feedback (0.3),
           maxDelayTime_msec (20.0),
+          buf(),
+          bufferArena(),
           writePointer (0),
-          lfo ({ 0.0, 0.5, sampleRate }),
+          lfo ({ Phasor(), 0.5, sampleRate }),
           depth (0.1),
           dryLevel (1.0),
           wetLevel (1.0),
@@ -65,25 +57,36 @@ public:
         prepare();
     };
 
-    void render (IAudioBuffer* outputAudio, int startSample, int numSamples);
+    void render (IAudioBuffer<SampleType>* outputAudio, int startSample, int numSamples);
     void setCurrentPlaybackSampleRate (double _sampleRate);
+    // The owner of `arena` places the buffer with placeBuffers() after
+    // setCurrentPlaybackSampleRate()
+    void useBufferArena (BufferArena& arena);
+    void placeBuffers (BufferArena::Placer& placer);
 
 private:
-    flnum sampleRate;
-    flnum delayTime_msec;
-    flnum feedback;
-    flnum maxDelayTime_msec;
-    std::vector<flnum> buf;
+    SampleType sampleRate;
+    SampleType delayTime_msec;
+    SampleType feedback;
+    SampleType maxDelayTime_msec;
+    // Long enough for the maximum delay at the sample rate
+    ArenaBuffer<SampleType> buf;
+    LocalBufferArena bufferArena;
     int writePointer;
     ChorusLfo lfo;
-    flnum depth;
-    flnum dryLevel;
-    flnum wetLevel;
+    SampleType depth;
+    SampleType dryLevel;
+    SampleType wetLevel;
     bool interpolateBufferAccess;
 
     //==============================================================================
     void prepare();
 
+    int getBufSize() const
+    {
+        return static_cast<int> (sampleRate * maxDelayTime_msec / 1000.0);
+    }
+
     inline int delaySample()
     {
         return static_cast<int> (delayTime_msec * (1.0 + depth * lfo.val()) / 1000.0 * sampleRate);
@@ -95,47 +98,47 @@ private:
         return idx >= 0 ? idx : idx + static_cast<int> (buf.size());
     }
 
-    inline flnum getModDelayValueWithoutInterpolation()
+    inline SampleType getModDelayValueWithoutInterpolation()
     {
-        return buf.at (readIdx());
+        return buf[readIdx()];
     }
 
-    inline flnum delayTimeInSec()
+    inline SampleType delayTimeInSec()
     {
         return delayTime_msec * (1.0 + depth * lfo.val()) / 1000.0;
     }
 
-    inline int firstReadIdx (const flnum delayTimeInSample)
+    inline int firstReadIdx (const SampleType delayTimeInSample)
     {
         const int idx = writePointer - (static_cast<int> (delayTimeInSample) + 1);
 
         return idx >= 0 ? idx : idx + static_cast<int> (buf.size());
     }
 
-    inline flnum firstReadSampleRatio (const flnum delayTimeInSample)
+    inline SampleType firstReadSampleRatio (const SampleType delayTimeInSample)
     {
         return delayTimeInSample - std::floor (delayTimeInSample);
     }
 
-    inline flnum getBufValueWithInterpolation (int firstIdx, int secondIdx, flnum firstRatio)
+    inline SampleType getBufValueWithInterpolation (int firstIdx, int secondIdx, SampleType firstRatio)
     {
         // [Circuit Bending]
         // return buf.at(firstIdx) * firstIdx + buf.at(secondIdx) * (1.0 - firstIdx);
-        return buf.at (firstIdx) * firstRatio + buf.at (secondIdx) * (1.0 - firstRatio);
+        return buf[firstIdx] * firstRatio + buf[secondIdx] * (1.0 - firstRatio);
     }
 
-    inline flnum getModDelayValueWithInterpolation()
+    inline SampleType getModDelayValueWithInterpolation()
     {
         // Use linear interpolation
         // https://ccrma.stanford.edu/~jos/pasp/Delay_Line_Interpolation.html
-        const flnum delayTimeInSample = delayTimeInSec() * sampleRate;
-        const flnum firstIdx = firstReadIdx (delayTimeInSample);
-        const flnum secondIdx = (firstIdx == static_cast<int> (buf.size()) - 1) ? 0 : firstIdx + 1;
-        const flnum firstRatio = firstReadSampleRatio (delayTimeInSample);
+        const SampleType delayTimeInSample = delayTimeInSec() * sampleRate;
+        const SampleType firstIdx = firstReadIdx (delayTimeInSample);
+        const SampleType secondIdx = (firstIdx == static_cast<int> (buf.size()) - 1) ? 0 : firstIdx + 1;
+        const SampleType firstRatio = firstReadSampleRatio (delayTimeInSample);
         return getBufValueWithInterpolation (firstIdx, secondIdx, firstRatio);
     }
 
-    inline flnum getModDelayValue()
+    inline SampleType getModDelayValue()
     {
         if (interpolateBufferAccess)
         {
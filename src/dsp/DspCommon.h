@@ -11,6 +11,24 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OS251_HAS_SSE2 1
+#else
+#define OS251_HAS_SSE2 0
+#endif
+
+// Use polynomial approximations instead of the standard library for
+// DspMath::sin(), cos(), tan(), exp2() and log2().
+// Enable it with `-DOS251_FAST_MATH=ON` when configuring CMake.
+#ifndef OS251_FAST_MATH
+#define OS251_FAST_MATH 0
+#endif
 
 namespace onsen
 {
@@ -18,8 +36,19 @@ namespace onsen
 using flnum = float;
 static constexpr flnum DEFAULT_SAMPLE_RATE = 44100.0;
 static constexpr int DEFAULT_SAMPLES_PER_BLOCK = 512;
+// The synth renders the voices and the effects in chunks of up to this size
+static constexpr int INTERNAL_BLOCK_SIZE = 64;
+// Size of a cache line on x86-64 and most of ARM64
+static constexpr size_t CACHE_LINE_SIZE = 64;
+static constexpr size_t roundUpToCacheLine (size_t size)
+{
+    return (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
 // TODO: cnage const to capital letters
 static constexpr flnum pi = 3.141592653589793238L;
+// pi in the sample type of the DSP classes
+template <typename T>
+inline constexpr T pi_v = static_cast<T> (3.141592653589793238L);
 static constexpr flnum EPSILON = std::numeric_limits<flnum>::epsilon();
 //==============================================================================
 namespace DspUtil
@@ -68,46 +97,435 @@ namespace DspUtil
         return static_cast<int> (fval0to1 * (imax - imin) + 0.5) + imin;
     }
 
-    inline int timeSecToSample (flnum timeSec, double sampleRate)
+    template <typename T = flnum>
+    inline int timeSecToSample (T timeSec, double sampleRate)
     {
         return timeSec * sampleRate;
     }
 
-    inline flnum sampleToTimeSec (int sample, double sampleRate)
+    template <typename T = flnum>
+    inline T sampleToTimeSec (int sample, double sampleRate)
     {
         return sample / sampleRate;
     }
 } // namespace DspUtil
 
-class SmoothFlnum
+//==============================================================================
+/*
+DspMath
+
+Fast approximations of the math functions used in the per-sample paths.
+The error bounds below are measured against the double precision standard
+library over the whole domain, evaluating the approximation in float.
+
+- fastSin (x), fastCos (x) : absolute error < 3e-7 for |x| <= 8192 [rad]
+- fastTan (x)              : relative error < 4e-7 for |x| <= pi/4,
+                             relative error < 2e-5 for |x| <= pi/2 - 0.01
+- fastExp2 (x)             : relative error < 2.5e-7 for x in [-126, 127]
+- fastLog2 (x)             : absolute error < 1.5e-7 for x in [0.5, 2],
+                             relative error < 1.1e-7 for other positive normal x
+
+sin(), cos(), tan(), exp2() and log2() select between the approximations and
+the standard library according to OS251_FAST_MATH, so that we can
+benchmark both of them with the same code.
+
+The *Block() functions process arrays and use SSE2 for float when it's available.
+*/
+namespace DspMath
+{
+    template <typename T>
+    inline constexpr T twoPi = static_cast<T> (2.0L * 3.141592653589793238L);
+    template <typename T>
+    inline constexpr T halfPi = static_cast<T> (0.5L * 3.141592653589793238L);
+
+    namespace detail
+    {
+        // 2 * pi = twoPiHi + twoPiLo. twoPiHi has only 8 significant bits.
+        constexpr double twoPiHi = 6.28125;
+        constexpr double twoPiLo = 0.0019353071795864769;
+
+        // Minimax polynomial of sin (x) on [-pi/2, pi/2] (odd terms only)
+        constexpr double sinC1 = 0.9999999765903836;
+        constexpr double sinC3 = -0.1666664763487128;
+        constexpr double sinC5 = 0.008332899826398616;
+        constexpr double sinC7 = -0.00019800897915698304;
+        constexpr double sinC9 = 2.590488760989758e-06;
+
+        // Minimax polynomial of 2^x on [0, 1)
+        constexpr double exp2C0 = 0.9999998931101397;
+        constexpr double exp2C1 = 0.6931547525048383;
+        constexpr double exp2C2 = 0.24013971087374109;
+        constexpr double exp2C3 = 0.0558662468756783;
+        constexpr double exp2C4 = 0.008942828360572967;
+        constexpr double exp2C5 = 0.001896461386188741;
+
+        // log2 (m) = 2 / ln (2) * atanh (s), s = (m - 1) / (m + 1)
+        constexpr double log2C1 = 2.8853900817779268; // 2 / ln (2)
+        constexpr double log2C3 = log2C1 / 3.0;
+        constexpr double log2C5 = log2C1 / 5.0;
+        constexpr double log2C7 = log2C1 / 7.0;
+        constexpr double sqrtHalf = 0.7071067811865476;
+
+        // x in [-pi/2, pi/2]
+        template <typename T>
+        inline T sinPoly (T x)
+        {
+            const T x2 = x * x;
+            return x * (T (sinC1) + x2 * (T (sinC3) + x2 * (T (sinC5) + x2 * (T (sinC7) + x2 * T (sinC9)))));
+        }
+
+        // x in [0, 1)
+        template <typename T>
+        inline T exp2Poly (T x)
+        {
+            return T (exp2C0) + x * (T (exp2C1) + x * (T (exp2C2) + x * (T (exp2C3) + x * (T (exp2C4) + x * T (exp2C5)))));
+        }
+
+        // s in [-0.172, 0.172]
+        template <typename T>
+        inline T log2Poly (T s)
+        {
+            const T s2 = s * s;
+            return s * (T (log2C1) + s2 * (T (log2C3) + s2 * (T (log2C5) + s2 * T (log2C7))));
+        }
+
+        // Wrap x to [-pi, pi]
+        // (Cody-Waite reduction: k * twoPiHi is exact for |k| < 2^16)
+        template <typename T>
+        inline T wrapAngle (T x)
+        {
+            constexpr T invTwoPi = T (1) / twoPi<T>;
+            const T k = std::floor (x * invTwoPi + T (0.5));
+            return (x - k * T (twoPiHi)) - k * T (twoPiLo);
+        }
+
+        // r in [-3pi/2, 3pi/2]
+        template <typename T>
+        inline T sinWrapped (T r)
+        {
+            // Fold to [-pi/2, pi/2] using sin (pi - a) == sin (a).
+            // `folded` can be negative when |r| > pi, so multiply the sign
+            // instead of using copysign (sinPoly (folded), r).
+            const T a = std::abs (r);
+            const T folded = std::min (a, twoPi<T> / 2 - a);
+            return std::copysign (T (1), r) * sinPoly (folded);
+        }
+    } // namespace detail
+
+    template <typename T>
+    inline T fastSin (T x)
+    {
+        static_assert (std::is_floating_point_v<T>);
+        return detail::sinWrapped (detail::wrapAngle (x));
+    }
+
+    template <typename T>
+    inline T fastCos (T x)
+    {
+        static_assert (std::is_floating_point_v<T>);
+        return detail::sinWrapped (detail::wrapAngle (x) + halfPi<T>);
+    }
+
+    template <typename T>
+    inline T fastTan (T x)
+    {
+        return fastSin (x) / fastCos (x);
+    }
+
+    template <typename T>
+    inline T fastExp2 (T x)
+    {
+        static_assert (std::is_floating_point_v<T>);
+        if constexpr (std::is_same_v<T, float>)
+        {
+            x = std::clamp (x, -126.0f, 127.0f);
+            const float xi = std::floor (x);
+            const float p = detail::exp2Poly (x - xi);
+            std::int32_t bits;
+            std::memcpy (&bits, &p, sizeof (bits));
+            bits += static_cast<std::int32_t> (xi) << 23;
+            float result;
+            std::memcpy (&result, &bits, sizeof (result));
+            return result;
+        }
+        else
+        {
+            x = std::clamp<T> (x, -1022.0, 1023.0);
+            const T xi = std::floor (x);
+            const double p = detail::exp2Poly (static_cast<double> (x - xi));
+            std::int64_t bits;
+            std::memcpy (&bits, &p, sizeof (bits));
+            bits += static_cast<std::int64_t> (xi) << 52;
+            double result;
+            std::memcpy (&result, &bits, sizeof (result));
+            return static_cast<T> (result);
+        }
+    }
+
+    // x should be a positive normal number
+    template <typename T>
+    inline T fastLog2 (T x)
+    {
+        static_assert (std::is_floating_point_v<T>);
+        // x = m * 2^e, m in [sqrt(0.5), sqrt(2))
+        int e = 0;
+        T m = std::frexp (x, &e); // m in [0.5, 1)
+        if (m < T (detail::sqrtHalf))
+        {
+            m *= 2;
+            --e;
+        }
+        return static_cast<T> (e) + detail::log2Poly ((m - 1) / (m + 1));
+    }
+
+    //==============================================================================
+    // Switchable functions. See OS251_FAST_MATH.
+    template <typename T>
+    inline T sin (T x)
+    {
+#if OS251_FAST_MATH
+        return fastSin (x);
+#else
+        return std::sin (x);
+#endif
+    }
+
+    template <typename T>
+    inline T cos (T x)
+    {
+#if OS251_FAST_MATH
+        return fastCos (x);
+#else
+        return std::cos (x);
+#endif
+    }
+
+    template <typename T>
+    [[maybe_unused]] inline T tan (T x)
+    {
+#if OS251_FAST_MATH
+        return fastTan (x);
+#else
+        return std::tan (x);
+#endif
+    }
+
+    template <typename T>
+    inline T exp2 (T x)
+    {
+#if OS251_FAST_MATH
+        return fastExp2 (x);
+#else
+        return std::exp2 (x);
+#endif
+    }
+
+    template <typename T>
+    [[maybe_unused]] inline T log2 (T x)
+    {
+#if OS251_FAST_MATH
+        return fastLog2 (x);
+#else
+        return std::log2 (x);
+#endif
+    }
+
+    //==============================================================================
+    // SIMD versions
+#if OS251_HAS_SSE2
+    namespace detail
+    {
+        inline __m128 wrapAngle4 (__m128 x)
+        {
+            const __m128 twoPiHi4 = _mm_set1_ps (static_cast<float> (twoPiHi));
+            const __m128 twoPiLo4 = _mm_set1_ps (static_cast<float> (twoPiLo));
+            const __m128 invTwoPi4 = _mm_set1_ps (1.0f / twoPi<float>);
+            // _mm_cvtps_epi32 rounds to nearest
+            const __m128 k = _mm_cvtepi32_ps (_mm_cvtps_epi32 (_mm_mul_ps (x, invTwoPi4)));
+            return _mm_sub_ps (_mm_sub_ps (x, _mm_mul_ps (twoPiHi4, k)), _mm_mul_ps (twoPiLo4, k));
+        }
+
+        inline __m128 sinWrapped4 (__m128 r)
+        {
+            const __m128 pi4 = _mm_set1_ps (twoPi<float> / 2.0f);
+            const __m128 signMask = _mm_set1_ps (-0.0f);
+            const __m128 sign = _mm_and_ps (r, signMask);
+            const __m128 a = _mm_andnot_ps (signMask, r);
+            const __m128 f = _mm_min_ps (a, _mm_sub_ps (pi4, a));
+
+            const __m128 f2 = _mm_mul_ps (f, f);
+            __m128 p = _mm_set1_ps (static_cast<float> (sinC9));
+            p = _mm_add_ps (_mm_mul_ps (p, f2), _mm_set1_ps (static_cast<float> (sinC7)));
+            p = _mm_add_ps (_mm_mul_ps (p, f2), _mm_set1_ps (static_cast<float> (sinC5)));
+            p = _mm_add_ps (_mm_mul_ps (p, f2), _mm_set1_ps (static_cast<float> (sinC3)));
+            p = _mm_add_ps (_mm_mul_ps (p, f2), _mm_set1_ps (static_cast<float> (sinC1)));
+            return _mm_xor_ps (_mm_mul_ps (p, f), sign);
+        }
+
+        inline __m128 fastExp2_4 (__m128 x)
+        {
+            x = _mm_min_ps (_mm_max_ps (x, _mm_set1_ps (-126.0f)), _mm_set1_ps (127.0f));
+            // floor (x) for x in [-126, 127]
+            __m128i xi = _mm_cvttps_epi32 (x);
+            __m128 xf = _mm_cvtepi32_ps (xi);
+            const __m128 fix = _mm_and_ps (_mm_cmpgt_ps (xf, x), _mm_set1_ps (1.0f));
+            xf = _mm_sub_ps (xf, fix);
+            xi = _mm_cvtps_epi32 (xf);
+
+            const __m128 f = _mm_sub_ps (x, xf);
+            __m128 p = _mm_set1_ps (static_cast<float> (exp2C5));
+            p = _mm_add_ps (_mm_mul_ps (p, f), _mm_set1_ps (static_cast<float> (exp2C4)));
+            p = _mm_add_ps (_mm_mul_ps (p, f), _mm_set1_ps (static_cast<float> (exp2C3)));
+            p = _mm_add_ps (_mm_mul_ps (p, f), _mm_set1_ps (static_cast<float> (exp2C2)));
+            p = _mm_add_ps (_mm_mul_ps (p, f), _mm_set1_ps (static_cast<float> (exp2C1)));
+            p = _mm_add_ps (_mm_mul_ps (p, f), _mm_set1_ps (static_cast<float> (exp2C0)));
+            return _mm_castsi128_ps (_mm_add_epi32 (_mm_castps_si128 (p), _mm_slli_epi32 (xi, 23)));
+        }
+    } // namespace detail
+#endif
+
+    template <typename T>
+    [[maybe_unused]] inline void fastSinBlock (const T* in, T* out, int numSamples)
+    {
+        int i = 0;
+#if OS251_HAS_SSE2
+        if constexpr (std::is_same_v<T, float>)
+        {
+            for (; i + 4 <= numSamples; i += 4)
+                _mm_storeu_ps (out + i, detail::sinWrapped4 (detail::wrapAngle4 (_mm_loadu_ps (in + i))));
+        }
+#endif
+        for (; i < numSamples; ++i)
+            out[i] = fastSin (in[i]);
+    }
+
+    template <typename T>
+    [[maybe_unused]] inline void fastCosBlock (const T* in, T* out, int numSamples)
+    {
+        int i = 0;
+#if OS251_HAS_SSE2
+        if constexpr (std::is_same_v<T, float>)
+        {
+            const __m128 offset = _mm_set1_ps (halfPi<float>);
+            for (; i + 4 <= numSamples; i += 4)
+                _mm_storeu_ps (out + i, detail::sinWrapped4 (_mm_add_ps (detail::wrapAngle4 (_mm_loadu_ps (in + i)), offset)));
+        }
+#endif
+        for (; i < numSamples; ++i)
+            out[i] = fastCos (in[i]);
+    }
+
+    template <typename T>
+    [[maybe_unused]] inline void fastExp2Block (const T* in, T* out, int numSamples)
+    {
+        int i = 0;
+#if OS251_HAS_SSE2
+        if constexpr (std::is_same_v<T, float>)
+        {
+            for (; i + 4 <= numSamples; i += 4)
+                _mm_storeu_ps (out + i, detail::fastExp2_4 (_mm_loadu_ps (in + i)));
+        }
+#endif
+        for (; i < numSamples; ++i)
+            out[i] = fastExp2 (in[i]);
+    }
+
+    // Switchable block version of sin(). `out` can be `in` itself.
+    template <typename T>
+    [[maybe_unused]] inline void sinBlock (const T* in, T* out, int numSamples)
+    {
+#if OS251_FAST_MATH
+        fastSinBlock (in, out, numSamples);
+#else
+        for (int i = 0; i < numSamples; ++i)
+            out[i] = std::sin (in[i]);
+#endif
+    }
+
+    template <typename T>
+    [[maybe_unused]] inline void fastLog2Block (const T* in, T* out, int numSamples)
+    {
+        // frexp() doesn't vectorize, so there is no SSE2 path for now.
+        for (int i = 0; i < numSamples; ++i)
+            out[i] = fastLog2 (in[i]);
+    }
+} // namespace DspMath
+
+//==============================================================================
+// One-pole smoother. Each step moves the value towards the target by
+// `cur = target + (cur - target) * smoothness`.
+// It keeps the difference from the target instead of the value, so the steps
+// can be advanced in closed form and the value doesn't get stuck short of the
+// target because of rounding. Once the difference is negligible the value
+// snaps to the target and it's settled, which costs nothing until the target
+// changes.
+template <typename T>
+class SmoothValue
 {
 public:
-    SmoothFlnum (flnum val, flnum _smoothness)
+    SmoothValue (T val, T _smoothness)
         : sampleRate (DEFAULT_SAMPLE_RATE),
           target (val),
           cur (val),
+          diff (0),
           smoothness (_smoothness),
           adjustedSmoothness (_smoothness),
           initialized (false) {}
-    flnum get() const { return cur; }
-    void update() { cur = adjustedSmoothness * cur + (1 - adjustedSmoothness) * target; }
-    void set (flnum val)
+    T get() const { return cur; }
+    bool isSettled() const { return diff == 0; }
+    void update()
+    {
+        if (isSettled())
+        {
+            return;
+        }
+        diff *= adjustedSmoothness;
+        settleIfNegligible();
+    }
+    // Same as calling update() `numSteps` times
+    void advance (int numSteps)
+    {
+        if (isSettled() || numSteps <= 0)
+        {
+            return;
+        }
+        if (numSteps == 1)
+        {
+            update();
+            return;
+        }
+        diff *= std::pow (adjustedSmoothness, static_cast<T> (numSteps));
+        settleIfNegligible();
+    }
+    void set (T val)
     {
         if (! initialized)
         {
             reset (val); // `initialized` becomees true here
             return;
         }
+        if (val == target)
+        {
+            return;
+        }
         target = val;
+        diff = cur - target;
+        settleIfNegligible();
     }
-    void reset (flnum val)
+    void reset (T val)
     {
         target = val;
         cur = val;
+        diff = 0;
         initialized = true;
     }
-    void setSmoothness (flnum val)
+    void setSmoothness (T val)
     {
+        // adjust() calls std::pow, so skip it when nothing changes
+        if (val == smoothness)
+        {
+            return;
+        }
         smoothness = val;
         adjustedSmoothness = adjust (smoothness);
     }
@@ -122,50 +540,72 @@ public:
     }
 
 private:
-    flnum sampleRate;
-    flnum target;
-    flnum cur;
-    flnum smoothness;
-    flnum adjustedSmoothness;
+    // Differences below it are inaudible
+    static constexpr T relativeSettleThreshold = 1e-6;
+    static constexpr T absoluteSettleThreshold = 1e-9;
+
+    T sampleRate;
+    T target;
+    T cur;
+    T diff; // cur - target
+    T smoothness;
+    T adjustedSmoothness;
     bool initialized;
 
+    void settleIfNegligible()
+    {
+        if (std::abs (diff) <= std::abs (target) * relativeSettleThreshold + absoluteSettleThreshold)
+        {
+            diff = 0;
+            cur = target;
+            return;
+        }
+        cur = target + diff;
+    }
+
     // Adjust parameter value like attack, decay or release according to the
     // sampling rate
-    flnum adjust (const flnum val) const
+    T adjust (const T val) const
     {
         // If no need to adjust
         if (std::abs (sampleRate - DEFAULT_SAMPLE_RATE) <= EPSILON || val == 0)
         {
             return val;
         }
-        const flnum amount = std::pow (val, DEFAULT_SAMPLE_RATE / sampleRate - 1);
+        const T amount = std::pow (val, DEFAULT_SAMPLE_RATE / sampleRate - 1);
         return val * amount;
     }
 };
 
+using SmoothFlnum = SmoothValue<flnum>;
+
 namespace ZeroOneToZeroOne
 {
-    [[maybe_unused]] inline flnum linear (flnum x)
+    template <typename T>
+    [[maybe_unused]] inline T linear (T x)
     {
         return x;
     }
 
-    inline flnum square (flnum x)
+    template <typename T>
+    inline T square (T x)
     {
-        x = std::clamp (x, 0.0f, 1.0f);
+        x = std::clamp<T> (x, 0, 1);
         return x * x;
     }
 
-    [[maybe_unused]] inline flnum invert (flnum x)
+    template <typename T>
+    [[maybe_unused]] inline T invert (T x)
     {
-        x = std::clamp (x, 0.0f, 1.0f);
+        x = std::clamp<T> (x, 0, 1);
         return x * x;
     }
 
-    [[maybe_unused]] inline flnum tanh (flnum x)
+    template <typename T>
+    [[maybe_unused]] inline T tanh (T x)
     {
-        x = std::clamp (x, 0.0f, 1.0f);
-        return std::tanh ((x - 0.5) * 2 * pi) * 0.5 + 0.5;
+        x = std::clamp<T> (x, 0, 1);
+        return std::tanh ((x - T (0.5)) * 2 * pi_v<T>) * T (0.5) + T (0.5);
     }
 } // namespace ZeroOneToZeroOne
 
@@ -11,28 +11,31 @@
 namespace onsen
 {
 //==============================================================================
-void Envelope::noteOn()
+template <typename SampleType>
+void Envelope<SampleType>::noteOn()
 {
     sampleCnt = 0;
     state = State::ATTACK;
 }
 
-void Envelope::noteOff()
+template <typename SampleType>
+void Envelope<SampleType>::noteOff()
 {
     sampleCnt = 0;
     noteOffLevel = level;
     state = State::RELEASE;
 }
 
-void Envelope::update()
+template <typename SampleType>
+void Envelope<SampleType>::update()
 {
     if (state == State::OFF)
         return;
 
     if (state == State::ATTACK)
     {
-        const flnum attackSec = p->getAttack();
-        level = attackCurve (DspUtil::sampleToTimeSec (++sampleCnt, sampleRate), attackSec);
+        const SampleType attackSec = p->getAttack();
+        level = attackCurve (DspUtil::sampleToTimeSec<SampleType> (++sampleCnt, sampleRate), attackSec);
         if (sampleCnt >= DspUtil::timeSecToSample (attackSec, sampleRate))
         {
             sampleCnt = 0;
@@ -41,11 +44,11 @@ void Envelope::update()
     }
     else if (state == State::DECAY)
     {
-        const flnum decaySec = p->getDecay();
-        const flnum sustain = p->getSustain();
+        const SampleType decaySec = p->getDecay();
+        const SampleType sustain = p->getSustain();
         level = sustain
                 + (MAX_LEVEL - sustain)
-                      * decayCurve (DspUtil::sampleToTimeSec (++sampleCnt, sampleRate), decaySec);
+                      * decayCurve (DspUtil::sampleToTimeSec<SampleType> (++sampleCnt, sampleRate), decaySec);
         if (sampleCnt >= DspUtil::timeSecToSample (decaySec, sampleRate))
         {
             sampleCnt = 0;
@@ -59,9 +62,9 @@ void Envelope::update()
     }
     else if (state == State::RELEASE)
     {
-        const flnum releaseSec = p->getRelease();
+        const SampleType releaseSec = p->getRelease();
         level = noteOffLevel
-                * releaseCurve (DspUtil::sampleToTimeSec (++sampleCnt, sampleRate), releaseSec);
+                * releaseCurve (DspUtil::sampleToTimeSec<SampleType> (++sampleCnt, sampleRate), releaseSec);
         if (sampleCnt >= DspUtil::timeSecToSample (releaseSec, sampleRate))
         {
             sampleCnt = 0;
@@ -76,27 +79,30 @@ void Envelope::update()
 }
 
 //==============================================================================
-void Gate::noteOn()
+template <typename SampleType>
+void Gate<SampleType>::noteOn()
 {
     sampleCnt = 0;
     state = State::ATTACK;
 }
 
-void Gate::noteOff()
+template <typename SampleType>
+void Gate<SampleType>::noteOff()
 {
     sampleCnt = 0;
     noteOffLevel = level;
     state = State::RELEASE;
 }
 
-void Gate::update()
+template <typename SampleType>
+void Gate<SampleType>::update()
 {
     if (state == State::OFF)
         return;
 
     if (state == State::ATTACK)
     {
-        level = attackCurve (DspUtil::sampleToTimeSec (++sampleCnt, sampleRate), attackSec);
+        level = attackCurve (DspUtil::sampleToTimeSec<SampleType> (++sampleCnt, sampleRate), attackSec);
         if (sampleCnt >= DspUtil::timeSecToSample (attackSec, sampleRate))
         {
             sampleCnt = 0;
@@ -110,7 +116,7 @@ void Gate::update()
     else if (state == State::RELEASE)
     {
         level = noteOffLevel
-                * releaseCurve (DspUtil::sampleToTimeSec (++sampleCnt, sampleRate), releaseSec);
+                * releaseCurve (DspUtil::sampleToTimeSec<SampleType> (++sampleCnt, sampleRate), releaseSec);
         if (sampleCnt >= DspUtil::timeSecToSample (releaseSec, sampleRate))
         {
             sampleCnt = 0;
@@ -123,4 +129,10 @@ void Gate::update()
         assert (false && "Unknown state of gate");
     }
 }
+
+//==============================================================================
+template class Envelope<float>;
+template class Envelope<double>;
+template class Gate<float>;
+template class Gate<double>;
 } // namespace onsen
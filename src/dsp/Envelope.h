@@ -14,6 +14,7 @@
 namespace onsen
 {
 //==============================================================================
+template <typename SampleType>
 class IEnvelope
 {
 public:
@@ -29,14 +30,17 @@ public:
     virtual void noteOn() = 0;
     virtual void noteOff() = 0;
     virtual void update() = 0;
-    virtual flnum getLevel() const = 0;
-    virtual flnum isEnvOff() const = 0;
+    virtual SampleType getLevel() const = 0;
+    virtual SampleType isEnvOff() const = 0;
     virtual void setCurrentPlaybackSampleRate (const double newRate) = 0;
 };
 
 //==============================================================================
-class Envelope : public IEnvelope
+template <typename SampleType>
+class Envelope : public IEnvelope<SampleType>
 {
+    using State = typename IEnvelope<SampleType>::State;
+
 public:
     Envelope() = delete;
     Envelope (IEnvelopeParams* const envParams)
@@ -50,35 +54,35 @@ public:
     void noteOn() override;
     void noteOff() override;
     void update() override;
-    flnum getLevel() const override { return level; }
-    flnum isEnvOff() const override { return state == State::OFF; }
+    SampleType getLevel() const override { return level; }
+    SampleType isEnvOff() const override { return state == State::OFF; }
     void setCurrentPlaybackSampleRate (const double newRate) override { sampleRate = newRate; }
 
 private:
-    static constexpr flnum MAX_LEVEL = 1.0;
+    static constexpr SampleType MAX_LEVEL = 1.0;
 
     const IEnvelopeParams* const p;
-    flnum sampleRate;
+    SampleType sampleRate;
 
     State state;
-    flnum level;
-    flnum noteOffLevel;
+    SampleType level;
+    SampleType noteOffLevel;
     int sampleCnt;
 
     // Return value [0, 1]
-    flnum attackCurve (flnum curTimeSec, flnum lengthSec)
+    SampleType attackCurve (SampleType curTimeSec, SampleType lengthSec)
     {
         return curTimeSec / lengthSec;
     }
 
     // Return value [0, 1]
-    flnum decayCurve (flnum curTimeSec, flnum lengthSec)
+    SampleType decayCurve (SampleType curTimeSec, SampleType lengthSec)
     {
         return ZeroOneToZeroOne::square ((lengthSec - curTimeSec) / lengthSec);
     }
 
     // Return value [0, 1]
-    flnum releaseCurve (flnum curTimeSec, flnum lengthSec)
+    SampleType releaseCurve (SampleType curTimeSec, SampleType lengthSec)
     {
         return (lengthSec - curTimeSec) / lengthSec;
     }
@@ -86,8 +90,11 @@ private:
 
 //==============================================================================
 // Gate does not have ADSR but it has fixed attack and release around 1 [ms] instead.
-class Gate : public IEnvelope
+template <typename SampleType>
+class Gate : public IEnvelope<SampleType>
 {
+    using State = typename IEnvelope<SampleType>::State;
+
 public:
     Gate()
         : sampleRate (DEFAULT_SAMPLE_RATE),
@@ -99,31 +106,31 @@ public:
     void noteOn() override;
     void noteOff() override;
     void update() override;
-    flnum getLevel() const override { return level; }
-    flnum isEnvOff() const override { return state == State::OFF; }
+    SampleType getLevel() const override { return level; }
+    SampleType isEnvOff() const override { return state == State::OFF; }
     void setCurrentPlaybackSampleRate (const double newRate) override { sampleRate = newRate; }
 
 private:
-    static constexpr flnum MAX_LEVEL = 1.0;
+    static constexpr SampleType MAX_LEVEL = 1.0;
 
-    flnum sampleRate;
+    SampleType sampleRate;
 
     State state;
-    flnum level;
-    flnum noteOffLevel;
+    SampleType level;
+    SampleType noteOffLevel;
     int sampleCnt;
 
-    static constexpr flnum attackSec = 0.002; // [s]
-    static constexpr flnum releaseSec = 0.002; // [s]
+    static constexpr SampleType attackSec = 0.002; // [s]
+    static constexpr SampleType releaseSec = 0.002; // [s]
 
     // Return value [0, 1]
-    flnum attackCurve (flnum curTimeSec, flnum lengthSec)
+    SampleType attackCurve (SampleType curTimeSec, SampleType lengthSec)
     {
         return curTimeSec / lengthSec;
     }
 
     // Return value [0, 1]
-    flnum releaseCurve (flnum curTimeSec, flnum lengthSec)
+    SampleType releaseCurve (SampleType curTimeSec, SampleType lengthSec)
     {
         return (lengthSec - curTimeSec) / lengthSec;
     }
@@ -131,11 +138,12 @@ private:
 
 //==============================================================================
 // It allows you to switch between Gate and Envelope
-class EnvManager : public IEnvelope
+template <typename SampleType>
+class EnvManager : public IEnvelope<SampleType>
 {
 public:
     EnvManager() = delete;
-    EnvManager (Envelope* _env, Gate* _gate)
+    EnvManager (Envelope<SampleType>* _env, Gate<SampleType>* _gate)
         : env (_env),
           gate (_gate),
           target (env) {}
@@ -155,8 +163,8 @@ public:
         env->update();
         gate->update();
     };
-    flnum getLevel() const override { return target->getLevel(); }
-    flnum isEnvOff() const override { return target->isEnvOff(); }
+    SampleType getLevel() const override { return target->getLevel(); }
+    SampleType isEnvOff() const override { return target->isEnvOff(); }
     void setCurrentPlaybackSampleRate (const double newRate) override
     {
         env->setCurrentPlaybackSampleRate (newRate);
@@ -169,9 +177,9 @@ public:
     }
 
 private:
-    IEnvelope* env;
-    IEnvelope* gate;
-    IEnvelope* target;
+    IEnvelope<SampleType>* env;
+    IEnvelope<SampleType>* gate;
+    IEnvelope<SampleType>* target;
 };
 
 } // namespace onsen
@@ -12,65 +12,94 @@
 #include "DspCommon.h"
 #include "Envelope.h"
 #include "Lfo.h"
+#include "Modulation.h"
 
 namespace onsen
 {
 //==============================================================================
+template <typename SampleType>
 class Filter
 {
-    using flnum = float;
+    static constexpr SampleType pi = pi_v<SampleType>;
+
+    // Biquad coefficients divided by a0
+    struct Coefficients
+    {
+        SampleType b0, b1, b2, a1, a2;
+
+        Coefficients operator+ (const Coefficients& c) const { return { b0 + c.b0, b1 + c.b1, b2 + c.b2, a1 + c.a1, a2 + c.a2 }; }
+        Coefficients operator- (const Coefficients& c) const { return { b0 - c.b0, b1 - c.b1, b2 - c.b2, a1 - c.a1, a2 - c.a2 }; }
+        Coefficients operator* (SampleType k) const { return { b0 * k, b1 * k, b2 * k, a1 * k, a2 * k }; }
+    };
+
     struct FilterBuffer
     {
     public:
         FilterBuffer() : in1 (0.0), in2 (0.0), out1 (0.0), out2 (0.0) {}
         ~FilterBuffer() = default;
         ;
-        flnum in1, in2;
-        flnum out1, out2;
+        SampleType in1, in2;
+        SampleType out1, out2;
+
+        SampleType process (const Coefficients& c, SampleType sampleVal)
+        {
+            const SampleType out0 = c.b0 * sampleVal + c.b1 * in1 + c.b2 * in2
+                                    - c.a1 * out1 - c.a2 * out2;
+            in2 = in1;
+            in1 = sampleVal;
+
+            out2 = out1;
+            out1 = out0;
+
+            return out0;
+        }
     };
 
 public:
     Filter() = delete;
-    Filter (IFilterParams* const filterParams, Envelope* const _env, Lfo* const _lfo)
+    Filter (IFilterParams* const filterParams, const ModulationMatrix* const modulationMatrix, Envelope<SampleType>* const _env, Lfo<SampleType>* const _lfo)
         : p (filterParams),
+          matrix (modulationMatrix),
           env (_env),
           lfo (_lfo),
           sampleRate (DEFAULT_SAMPLE_RATE),
           fb(),
-          smoothedFreq (0.0, 0.995)
+          fbRight(),
+          smoothedFreq (0.0, 0.995),
+          coefficients()
     {
     }
 
-    flnum process (flnum sampleVal, int sampleIdx)
+    SampleType process (SampleType sampleVal, int sampleIdx)
     {
-        // Set biquad parameter coefficients
-        // https://webaudio.github.io/Audio-EQ-Cookbook/audio-eq-cookbook.html
-        flnum targetFreq = env->getLevel() * p->getFilterEnvelope()
-                           + lfo->getFilterFreqAmount() * lfo->getLevel (sampleIdx);
-        smoothedFreq.set (targetFreq);
-        smoothedFreq.update();
-        const flnum freq = p->getControlledFrequency (smoothedFreq.get());
-        const flnum omega0 = 2.0 * pi * freq / sampleRate;
-        const flnum sinw0 = std::sin (omega0);
-        const flnum cosw0 = std::cos (omega0);
-        // sp.getResonance() stands for "Q".
-        const flnum alpha = sinw0 / 2.0 / p->getResonance();
-        const flnum a0 = 1.0 + alpha;
-        const flnum a1 = -2.0 * cosw0;
-        const flnum a2 = 1.0 - alpha;
-        const flnum b0 = (1 - cosw0) / 2.0;
-        const flnum b1 = 1 - cosw0;
-        const flnum b2 = (1 - cosw0) / 2.0;
-
-        const flnum out0 = b0 / a0 * sampleVal + b1 / a0 * fb.in1 + b2 / a0 * fb.in2
-                           - a1 / a0 * fb.out1 - a2 / a0 * fb.out2;
-        fb.in2 = fb.in1;
-        fb.in1 = sampleVal;
-
-        fb.out2 = fb.out1;
-        fb.out1 = out0;
-
-        return out0;
+        return fb.process (nextCoefficients (sampleIdx), sampleVal);
+    }
+
+    // Filter two channels with the same modulation.
+    // The left channel shares the state with the mono process().
+    void processStereo (SampleType& left, SampleType& right, int sampleIdx)
+    {
+        const Coefficients c = nextCoefficients (sampleIdx);
+        left = fb.process (c, left);
+        right = fbRight.process (c, right);
+    }
+
+    // Continue from the mono state when processStereo() takes over process()
+    void copyStateToRight()
+    {
+        fbRight = fb;
+    }
+
+    // The envelope and the LFO modulate the frequency once per `numSamples`.
+    // 1 means audio rate.
+    void setControlInterval (int numSamples)
+    {
+        coefficients.setInterval (numSamples);
+    }
+
+    void resetModulation()
+    {
+        coefficients.reset();
     }
 
     void resetBuffer()
@@ -79,21 +108,56 @@ public:
         fb.in2 = 0.0;
         fb.out1 = 0.0;
         fb.out2 = 0.0;
+        fbRight = fb;
     }
 
     void setCurrentPlaybackSampleRate (double _sampleRate)
     {
-        sampleRate = static_cast<flnum> (_sampleRate);
+        sampleRate = static_cast<SampleType> (_sampleRate);
         smoothedFreq.prepareToPlay (_sampleRate);
     }
 
 private:
     const IFilterParams* const p;
-    IEnvelope* const env;
-    Lfo* const lfo;
-    flnum sampleRate;
-    // The length of this vector equals to max number of the channels;
+    const ModulationMatrix* const matrix;
+    IEnvelope<SampleType>* const env;
+    Lfo<SampleType>* const lfo;
+    SampleType sampleRate;
     FilterBuffer fb;
-    SmoothFlnum smoothedFreq;
+    FilterBuffer fbRight;
+    SmoothValue<SampleType> smoothedFreq;
+    ControlRateValue<SampleType, Coefficients> coefficients;
+
+    Coefficients nextCoefficients (int sampleIdx)
+    {
+        return coefficients.next ([this, sampleIdx] { return calculateCoefficients (sampleIdx); });
+    }
+
+    Coefficients calculateCoefficients (int sampleIdx)
+    {
+        // Set biquad parameter coefficients
+        // https://webaudio.github.io/Audio-EQ-Cookbook/audio-eq-cookbook.html
+        const ModSourceValues<SampleType> sources { lfo->getLevel (sampleIdx), env->getLevel() };
+        const SampleType targetFreq = matrix->modulate (ModDestination::filterFreq, sources);
+        smoothedFreq.set (targetFreq);
+        // Catch up with the samples until the next control point
+        smoothedFreq.advance (coefficients.getInterval());
+        const SampleType freq = p->getControlledFrequency (static_cast<flnum> (smoothedFreq.get()));
+        const SampleType omega0 = 2.0 * pi * freq / sampleRate;
+        const SampleType sinw0 = DspMath::sin (omega0);
+        // 1 - cos (w0) = 2 * sin^2 (w0 / 2). It avoids the cancellation of 1 - cos (w0)
+        // for low frequencies, which matters with the approximated sin/cos.
+        const SampleType sinHalfW0 = DspMath::sin (omega0 / 2);
+        const SampleType cosw0 = 1 - 2 * sinHalfW0 * sinHalfW0;
+        // sp.getResonance() stands for "Q".
+        const SampleType alpha = sinw0 / 2.0 / p->getResonance();
+        const SampleType a0 = 1.0 + alpha;
+        const SampleType a1 = -2.0 * cosw0;
+        const SampleType a2 = 1.0 - alpha;
+        const SampleType b0 = (1 - cosw0) / 2.0;
+        const SampleType b1 = 1 - cosw0;
+        const SampleType b2 = (1 - cosw0) / 2.0;
+        return { b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0 };
+    }
 };
 } // namespace onsen
@@ -8,7 +8,9 @@
 
 #pragma once
 
+#include "../services/Trace.h"
 #include "../synth/SynthParams.h"
+#include "BufferArena.h"
 #include "DspCommon.h"
 #include "Envelope.h"
 #include "IAudioBuffer.h"
@@ -17,17 +19,19 @@
 namespace onsen
 {
 //==============================================================================
+template <typename SampleType>
 class Hpf
 {
-    using flnum = float;
+    static constexpr SampleType pi = pi_v<SampleType>;
+
     struct FilterBuffer
     {
     public:
         FilterBuffer() : in1 (0.0), in2 (0.0), out1 (0.0), out2 (0.0) {}
         ~FilterBuffer() = default;
         ;
-        flnum in1, in2;
-        flnum out1, out2;
+        SampleType in1, in2;
+        SampleType out1, out2;
     };
 
 public:
@@ -36,49 +40,60 @@ public:
         : p (hpfParams),
           sampleRate (DEFAULT_SAMPLE_RATE),
           numChannels (_numChannels),
-          filterBuffers (numChannels),
-          smoothedFreq (0.0, 0.999)
+          filterBuffers(),
+          bufferArena(),
+          smoothedFreq (0.0, 0.999),
+          coefficientsFreq (0.0),
+          b0 (0.0),
+          b1 (0.0),
+          b2 (0.0),
+          a1 (0.0),
+          a2 (0.0)
     {
+        bufferArena.allocate ([this] (BufferArena::Placer& placer) { placeBuffers (placer); });
         smoothedFreq.reset (p->getFrequency());
+        coefficientsFreq = smoothedFreq.get();
+        updateCoefficients();
     }
 
-    void render (IAudioBuffer* outputAudio, int startSample, int numSamples)
+    void render (IAudioBuffer<SampleType>* outputAudio, int startSample, int numSamples)
     {
-        // Set biquad parameter coefficients
-        // https://webaudio.github.io/Audio-EQ-Cookbook/audio-eq-cookbook.html
+        OS251_TRACE_SCOPE ("Hpf::render");
+        prepareBlock (std::min (outputAudio->getNumSamples(), startSample + numSamples) - startSample);
+        process (outputAudio, startSample, numSamples);
+    }
 
-        flnum targetFreq = p->getFrequency();
-        smoothedFreq.set (targetFreq);
+    // Smooth the frequency over the block and update the coefficients.
+    // render() is prepareBlock() and process() of the whole block.
+    void prepareBlock (int numSamples)
+    {
+        smoothedFreq.set (p->getFrequency());
+        smoothedFreq.advance (numSamples);
 
-        int numInputChannels = outputAudio->getNumChannels();
-        int bufferSize = outputAudio->getNumSamples();
-        for (int i = startSample; i < bufferSize && i < startSample + numSamples; i++)
+        // The coefficients don't change once the frequency is settled
+        if (smoothedFreq.get() != coefficientsFreq)
         {
-            smoothedFreq.update();
+            coefficientsFreq = smoothedFreq.get();
+            updateCoefficients();
         }
+    }
 
-        flnum omega0 = 2.0f * 3.14159265f * smoothedFreq.get() / sampleRate;
-        flnum sinw0 = std::sin (omega0);
-        flnum cosw0 = std::cos (omega0);
-        constexpr flnum resonance = 1.0;
-        flnum alpha = sinw0 / 2.0 / resonance;
-        flnum a0 = 1.0 + alpha;
-        flnum a1 = -2.0 * cosw0;
-        flnum a2 = 1.0 - alpha;
-        flnum b0 = (1 + cosw0) / 2.0;
-        flnum b1 = -1 - cosw0;
-        flnum b2 = (1 + cosw0) / 2.0;
+    // Filter a part of the block prepared by prepareBlock()
+    void process (IAudioBuffer<SampleType>* outputAudio, int startSample, int numSamples)
+    {
+        int numInputChannels = outputAudio->getNumChannels();
+        int bufferSize = outputAudio->getNumSamples();
 
         // Calculate output
 
         for (int channel = 0; channel < std::min (numChannels, numInputChannels); channel++)
         {
             FilterBuffer& fb = filterBuffers[channel];
-            flnum* bufferPtr = outputAudio->getWritePointer (channel);
+            SampleType* bufferPtr = outputAudio->getWritePointer (channel);
             for (int i = startSample; i < bufferSize && i < startSample + numSamples; i++)
             {
-                flnum out0 = b0 / a0 * bufferPtr[i] + b1 / a0 * fb.in1 + b2 / a0 * fb.in2
-                             - a1 / a0 * fb.out1 - a2 / a0 * fb.out2;
+                SampleType out0 = b0 * bufferPtr[i] + b1 * fb.in1 + b2 * fb.in2
+                                  - a1 * fb.out1 - a2 * fb.out2;
                 fb.in2 = fb.in1;
                 fb.in1 = bufferPtr[i];
 
@@ -92,16 +107,49 @@ public:
 
     void setCurrentPlaybackSampleRate (double _sampleRate)
     {
-        sampleRate = static_cast<flnum> (_sampleRate);
+        sampleRate = static_cast<SampleType> (_sampleRate);
         smoothedFreq.prepareToPlay (_sampleRate);
+        updateCoefficients();
+    }
+
+    // The owner of `arena` places the buffers with placeBuffers()
+    void useBufferArena (BufferArena& arena)
+    {
+        bufferArena.share (arena);
+    }
+
+    void placeBuffers (BufferArena::Placer& placer)
+    {
+        placer.place (filterBuffers, numChannels);
     }
 
 private:
     const IHpfParams* const p;
-    flnum sampleRate;
+    SampleType sampleRate;
     int numChannels;
-    // The length of this vector equals to max number of the channels;
-    std::vector<FilterBuffer> filterBuffers;
-    SmoothFlnum smoothedFreq;
+    // The length of this buffer equals to max number of the channels;
+    ArenaBuffer<FilterBuffer> filterBuffers;
+    LocalBufferArena bufferArena;
+    SmoothValue<SampleType> smoothedFreq;
+    // Biquad coefficients divided by a0, and the frequency of them
+    SampleType coefficientsFreq;
+    SampleType b0, b1, b2, a1, a2;
+
+    void updateCoefficients()
+    {
+        // Set biquad parameter coefficients
+        // https://webaudio.github.io/Audio-EQ-Cookbook/audio-eq-cookbook.html
+        SampleType omega0 = 2 * pi * coefficientsFreq / sampleRate;
+        SampleType sinw0 = DspMath::sin (omega0);
+        SampleType cosw0 = DspMath::cos (omega0);
+        constexpr SampleType resonance = 1.0;
+        SampleType alpha = sinw0 / 2.0 / resonance;
+        SampleType a0 = 1.0 + alpha;
+        a1 = -2.0 * cosw0 / a0;
+        a2 = (1.0 - alpha) / a0;
+        b0 = (1 + cosw0) / 2.0 / a0;
+        b1 = (-1 - cosw0) / a0;
+        b2 = (1 + cosw0) / 2.0 / a0;
+    }
 };
 } // namespace onsen
@@ -13,13 +13,14 @@
 namespace onsen
 {
 //==============================================================================
+template <typename SampleType>
 class IAudioBuffer
 {
 public:
     virtual int getNumChannels() const noexcept = 0;
     virtual int getNumSamples() const noexcept = 0;
-    virtual flnum* getWritePointer (int channel) noexcept = 0;
-    virtual flnum getSample (int channel, int sampleIndex) const noexcept = 0;
-    virtual void setSample (int destChannel, int destSample, flnum newValue) noexcept = 0;
+    virtual SampleType* getWritePointer (int channel) noexcept = 0;
+    virtual SampleType getSample (int channel, int sampleIndex) const noexcept = 0;
+    virtual void setSample (int destChannel, int destSample, SampleType newValue) noexcept = 0;
 };
 } // namespace onsen
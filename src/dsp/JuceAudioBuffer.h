@@ -15,11 +15,12 @@
 namespace onsen
 {
 //==============================================================================
-class JuceAudioBuffer : public IAudioBuffer
+template <typename SampleType>
+class JuceAudioBuffer : public IAudioBuffer<SampleType>
 {
 public:
     JuceAudioBuffer() = delete;
-    JuceAudioBuffer (juce::AudioBuffer<flnum>* _audioBuffer) : audioBuffer (_audioBuffer) {}
+    JuceAudioBuffer (juce::AudioBuffer<SampleType>* _audioBuffer) : audioBuffer (_audioBuffer) {}
 
     int getNumChannels() const noexcept override
     {
@@ -31,22 +32,22 @@ public:
         return audioBuffer->getNumSamples();
     }
 
-    flnum* getWritePointer (int channel) noexcept override
+    SampleType* getWritePointer (int channel) noexcept override
     {
         return audioBuffer->getWritePointer (channel);
     }
 
-    flnum getSample (int channel, int sampleIndex) const noexcept override
+    SampleType getSample (int channel, int sampleIndex) const noexcept override
     {
         return audioBuffer->getSample (channel, sampleIndex);
     }
 
-    void setSample (int destChannel, int destSample, flnum newValue) noexcept override
+    void setSample (int destChannel, int destSample, SampleType newValue) noexcept override
     {
         audioBuffer->setSample (destChannel, destSample, newValue);
     }
 
 private:
-    juce::AudioBuffer<flnum>* audioBuffer;
+    juce::AudioBuffer<SampleType>* audioBuffer;
 };
 } // namespace onsen
@@ -9,15 +9,19 @@
 #pragma once
 
 #include "../synth/SynthParams.h"
+#include "BufferArena.h"
 #include "DspCommon.h"
 #include "IPositionInfo.h"
-#include <vector>
+#include "Phasor.h"
 
 namespace onsen
 {
 //==============================================================================
+template <typename SampleType>
 class Lfo
 {
+    static constexpr SampleType pi = pi_v<SampleType>;
+
 public:
     Lfo() = delete;
     Lfo (ILfoParams* const lfoParams, const IPositionInfo* _positionInfo)
@@ -26,16 +30,18 @@ public:
           sampleRate (DEFAULT_SAMPLE_RATE),
           numNoteOn (0),
           samplesPerBlock (DEFAULT_SAMPLES_PER_BLOCK),
-          buf (samplesPerBlock),
-          bufSync (samplesPerBlock),
-          currentAngle (0.0),
-          currentAngleSync (0.0),
+          buf(),
+          bufSync(),
+          bufferArena(),
+          phase(),
+          phaseSync(),
           amp (0.0),
           ampSync (0.0),
           isPlaying (false),
           basePosistionInQuarterNote (0.0),
-          baseAngle (0.0)
+          basePhase()
     {
+        allocateBuffers();
     }
 
     void noteOn()
@@ -44,12 +50,11 @@ public:
         ++numNoteOn;
         if (firstNote)
         {
-            constexpr flnum ampNoteStart = MAX_LEVEL * 0.01;
+            constexpr SampleType ampNoteStart = MAX_LEVEL * 0.01;
             amp = ampNoteStart;
             ampSync = ampNoteStart;
-            const flnum phase = p->getPhase();
-            currentAngle = 0.0 + phase;
-            currentAngleSync = 0.0 + phase;
+            phase = Phasor::fromRadians (p->getPhase());
+            phaseSync = phase;
         }
     }
 
@@ -63,7 +68,7 @@ public:
         numNoteOn = 0;
     }
 
-    flnum getLevel (int sample) const
+    SampleType getLevel (int sample) const
     {
         if (p->getSyncOn())
         {
@@ -77,21 +82,19 @@ public:
     void renderLfo (int startSample, int numSamples)
     {
         int idx = startSample;
+        const Phasor::Phase increment = Phasor::toIncrement (p->getRate() / sampleRate);
         while (--numSamples >= 0)
         {
             assert (idx < buf.size());
-            buf[idx++] = lfoWave (currentAngle) * amp;
-            const flnum angleDelta = getAngleDelta();
-            currentAngle += angleDelta;
-            if (currentAngle > pi * 2.0)
-            {
-                currentAngle -= pi * 2.0;
-            }
+            buf[idx++] = lfoWave (phase) * amp;
+            phase.advance (increment);
             updateAmp();
         }
     }
 
-    void renderLfoSync (int startSample, int numSamples)
+    // `blockPosition` is the position of `startSample` in the host's block,
+    // where the host's PPQ position is
+    void renderLfoSync (int startSample, int numSamples, int blockPosition = 0)
     {
         int idx = startSample;
 
@@ -101,14 +104,14 @@ public:
             return;
         }
 
-        const flnum bpm = positionInfo->getBpm();
+        const SampleType bpm = positionInfo->getBpm();
 
         if (! isPlaying && positionInfo->isPlaying())
         {
             // When DAW starts to play
             isPlaying = true;
             basePosistionInQuarterNote = positionInfo->getPpqPosition();
-            baseAngle = currentAngle;
+            basePhase = phase;
         }
 
         if (isPlaying && ! positionInfo->isPlaying())
@@ -117,45 +120,35 @@ public:
             isPlaying = false;
         }
 
-        const flnum beatsPerSec = positionInfo->getBpm() / 60.0; // [quarter note / sec]
-        const flnum quarterNotesFromBaseToStartIdx = positionInfo->getPpqPosition() - basePosistionInQuarterNote; // [quarter note]
+        const SampleType beatsPerSec = positionInfo->getBpm() / 60.0; // [quarter note / sec]
+        const SampleType quarterNotesFromBaseToStartIdx = positionInfo->getPpqPosition() - basePosistionInQuarterNote; // [quarter note]
+        const Phasor::Phase increment = Phasor::toIncrement (cyclesPerSample (bpm));
         while (--numSamples >= 0)
         {
-            // LFO angle from the time DAW starts to play.
-            flnum angleFromBase = 0.0; // initialize
+            phaseSync.advance (increment);
+
+            // In general we want to use the LFO phase from the time DAW starts
+            // to play because it's more accurate than the accumulated one.
+            // However, we cannot use it in some cases.
+            // e.g. DAW stops playing. Or DAW uses audio play with loop.
+            // In such cases, it might be much different from true value,
+            // so we use the accumulated one instead.
             if (isPlaying)
             {
                 assert (idx < bufSync.size());
-                const flnum timeFromBufStartToIdx = (idx - startSample) / sampleRate; // [sec]
-                const flnum quarterNotesFromBaseToIdx = quarterNotesFromBaseToStartIdx
+                const SampleType timeFromBufStartToIdx = (blockPosition + idx - startSample) / sampleRate; // [sec]
+                const SampleType quarterNotesFromBaseToIdx = quarterNotesFromBaseToStartIdx
                                                         + beatsPerSec * timeFromBufStartToIdx; // [quarter note]
-                const flnum barFromBaseToIdx = quarterNotesFromBaseToIdx / 4;
-                angleFromBase = barFromBaseToIdx / p->getRateSync() * 2 * pi - baseAngle;
-            }
-
-            const flnum angleAccumulated = currentAngleSync + angleDelta (bpm);
-
-            // In general we want to use angleFromBase because it's
-            // more accurate than angleAccumulated.
-            // However, we cannot use use angleFromBase in some cases.
-            // e.g. DAW stops playing. Or DAW uses audio play with loop.
-            // In such cases, angleFromBase might be much different from true value,
-            // so we use angleAccumulated instead.
-            if (isPlaying && std::abs (angleFromBase - angleAccumulated) < 0.1)
-            {
-                currentAngleSync = angleFromBase;
-            }
-            else
-            {
-                currentAngleSync = angleAccumulated;
+                const SampleType barFromBaseToIdx = quarterNotesFromBaseToIdx / 4;
+                Phasor phaseFromBase = Phasor::fromCycles (barFromBaseToIdx / p->getRateSync());
+                phaseFromBase.advance (-basePhase.get());
+                if (std::abs (Phasor::radiansBetween (phaseSync, phaseFromBase)) < 0.1)
+                {
+                    phaseSync = phaseFromBase;
+                }
             }
 
-            bufSync[idx++] = lfoWave (currentAngleSync) * ampSync;
-
-            if (currentAngleSync > pi * 2.0)
-            {
-                currentAngleSync -= pi * 2.0;
-            }
+            bufSync[idx++] = lfoWave (phaseSync) * ampSync;
 
             updateAmpSync();
         }
@@ -178,67 +171,83 @@ public:
 
     void setCurrentPlaybackSampleRate (double _sampleRate)
     {
-        sampleRate = static_cast<flnum> (_sampleRate);
+        sampleRate = static_cast<SampleType> (_sampleRate);
+    }
+
+    int getSamplesPerBlock() const
+    {
+        return samplesPerBlock;
     }
 
     void setSamplesPerBlock (int _samplesPerBlock)
     {
         samplesPerBlock = _samplesPerBlock;
-        buf.resize (samplesPerBlock);
-        bufSync.resize (samplesPerBlock);
+        allocateBuffers();
+    }
+
+    // The owner of `arena` places the buffers with placeBuffers() after
+    // setSamplesPerBlock()
+    void useBufferArena (BufferArena& arena)
+    {
+        bufferArena.share (arena);
+    }
+
+    void placeBuffers (BufferArena::Placer& placer)
+    {
+        placer.place (buf, samplesPerBlock);
+        placer.place (bufSync, samplesPerBlock);
     }
 
 private:
-    static constexpr flnum MAX_LEVEL = 1.0;
+    static constexpr SampleType MAX_LEVEL = 1.0;
 
     const ILfoParams* const p;
     const IPositionInfo* positionInfo;
 
-    flnum sampleRate;
+    SampleType sampleRate;
     int numNoteOn;
 
     // ---
     int samplesPerBlock;
-    std::vector<flnum> buf;
-    std::vector<flnum> bufSync;
-    flnum currentAngle;
-    flnum currentAngleSync;
-    flnum amp;
-    flnum ampSync;
+    ArenaBuffer<SampleType> buf;
+    ArenaBuffer<SampleType> bufSync;
+    LocalBufferArena bufferArena;
+    Phasor phase;
+    Phasor phaseSync;
+    SampleType amp;
+    SampleType ampSync;
 
     // ---
     // For tempo on
     bool isPlaying;
     // DAW postion when play starts
-    flnum basePosistionInQuarterNote;
-    // DAW angle when play starts
-    flnum baseAngle;
+    SampleType basePosistionInQuarterNote;
+    // LFO phase when play starts
+    Phasor basePhase;
 
     // ---
 
-    static flnum lfoWave (flnum angle)
+    void allocateBuffers()
     {
-        return MAX_LEVEL * std::sin (angle);
+        bufferArena.allocate ([this] (BufferArena::Placer& placer) { placeBuffers (placer); });
     }
 
-    flnum getAngleDelta() const
+    static SampleType lfoWave (Phasor phase)
     {
-        const flnum rate = p->getRate();
-        return 2.0 * pi * rate / sampleRate;
+        return MAX_LEVEL * DspMath::sin (phase.radians<SampleType>());
     }
 
-    flnum angleDelta (flnum bpm) const
+    SampleType cyclesPerSample (SampleType bpm) const
     {
-        const flnum barInSec = 1.0 / bpm /*[min / quarter note]*/ * 60.0 * 4; // [sec]
-        const flnum deltaTime = 1.0 / sampleRate; // [sec]
-        const flnum period = p->getRateSync() * barInSec; // [bar] * [sec / bar] = [sec]
-        const flnum deltaAngle = 2.0 * pi * deltaTime / period; // [rad]
-        return deltaAngle;
+        const SampleType barInSec = 1.0 / bpm /*[min / quarter note]*/ * 60.0 * 4; // [sec]
+        const SampleType deltaTime = 1.0 / sampleRate; // [sec]
+        const SampleType period = p->getRateSync() * barInSec; // [bar] * [sec / bar] = [sec]
+        return deltaTime / period;
     }
 
     void updateAmp()
     {
-        constexpr flnum valFinishDelay = MAX_LEVEL * 0.99;
+        constexpr SampleType valFinishDelay = MAX_LEVEL * 0.99;
         // Value of adjust (getDelay()) is around 0.99
         amp = amp * MAX_LEVEL / adjust (p->getDelay());
         if (amp >= valFinishDelay)
@@ -249,7 +258,7 @@ private:
 
     void updateAmpSync()
     {
-        constexpr flnum valFinishDelay = MAX_LEVEL * 0.99;
+        constexpr SampleType valFinishDelay = MAX_LEVEL * 0.99;
         // Value of adjust (getDelay()) is around 0.99
         ampSync = ampSync * MAX_LEVEL / adjust (p->getDelay());
         if (ampSync >= valFinishDelay)
@@ -260,14 +269,14 @@ private:
 
     // Adjust parameter value like attack, decay or release according to the
     // sampling rate
-    flnum adjust (const flnum val) const
+    SampleType adjust (const SampleType val) const
     {
         // If no need to adjust
         if (std::abs (sampleRate - DEFAULT_SAMPLE_RATE) <= EPSILON)
         {
             return val;
         }
-        const flnum amount = std::pow (val, DEFAULT_SAMPLE_RATE / sampleRate - 1);
+        const SampleType amount = std::pow (val, DEFAULT_SAMPLE_RATE / sampleRate - 1);
         return val * amount;
     }
 };
@@ -8,37 +8,164 @@
 
 #pragma once
 
+#include "../services/Trace.h"
 #include "../synth/SynthParams.h"
 #include "DspCommon.h"
 #include "IAudioBuffer.h"
+#include <vector>
 
 namespace onsen
 {
 //==============================================================================
+// Applies the master volume and limits the output to ±clippingValue.
+// The gain ramps linearly from the previous block's one, so it's read once
+// per block without zipper noise.
+// The soft clip mode saturates with tanh. It uses first-order antiderivative
+// anti-aliasing (ADAA), so it doesn't need oversampling to be clean:
+// y[n] = (F (x[n]) - F (x[n - 1])) / (x[n] - x[n - 1]) where F is the
+// antiderivative of the clipper. It delays the signal by half a sample.
+template <typename SampleType>
 class MasterVolume
 {
 public:
-    MasterVolume (IMasterParams* const masterParams)
-        : p (masterParams) {}
-    void render (IAudioBuffer* outputAudio, int startSample, int numSamples)
+    MasterVolume() = delete;
+    MasterVolume (IMasterParams* const masterParams, int _numChannels)
+        : p (masterParams),
+          numChannels (_numChannels),
+          adaaStates (numChannels),
+          gain (0.0),
+          isGainInitialized (false),
+          startGain (0.0),
+          gainStep (0.0),
+          isSoftClipOn (false)
     {
-        int idx = startSample;
-        while (--numSamples >= 0)
+    }
+
+    void render (IAudioBuffer<SampleType>* outputAudio, int startSample, int numSamples)
+    {
+        OS251_TRACE_SCOPE ("MasterVolume::render");
+        numSamples = std::min (outputAudio->getNumSamples(), startSample + numSamples) - startSample;
+        prepareBlock (numSamples);
+        process (outputAudio, startSample, numSamples, 0);
+    }
+
+    // Read the parameters and set up the gain ramp over the block.
+    // render() is prepareBlock() and process() of the whole block.
+    void prepareBlock (int numSamples)
+    {
+        const SampleType targetGain = p->getMasterVolume() * gainAdjustment;
+        // No ramp from the initial value
+        startGain = isGainInitialized ? gain : targetGain;
+        gainStep = numSamples > 0 ? (targetGain - startGain) / numSamples : 0.0;
+        gain = targetGain;
+        isGainInitialized = true;
+
+        const bool wasSoftClipOn = isSoftClipOn;
+        isSoftClipOn = p->getSoftClipOn();
+        if (isSoftClipOn && ! wasSoftClipOn)
         {
-            const flnum gain = p->getMasterVolume();
-            for (auto i = outputAudio->getNumChannels(); --i >= 0;)
-            {
-                flnum inputVal = outputAudio->getSample (i, idx);
-                flnum outputVal = std::clamp (inputVal * gain * gainAdjustment, -clippingValue, clippingValue);
-                outputAudio->setSample (i, idx, outputVal);
-            }
-            idx++;
+            std::fill (adaaStates.begin(), adaaStates.end(), AdaaState());
+        }
+    }
+
+    // Process a part of the block prepared by prepareBlock(), which starts
+    // `offsetInBlock` samples after the beginning of the block
+    void process (IAudioBuffer<SampleType>* outputAudio, int startSample, int numSamples, int offsetInBlock)
+    {
+        for (int channel = 0; channel < outputAudio->getNumChannels(); ++channel)
+        {
+            SampleType* data = outputAudio->getWritePointer (channel) + startSample;
+            // The channels without the state are clipped hard
+            if (isSoftClipOn && channel < numChannels)
+                softClipBlock (data, numSamples, offsetInBlock, startGain, gainStep, adaaStates[channel]);
+            else
+                hardClipBlock (data, numSamples, offsetInBlock, startGain, gainStep);
         }
     }
 
 private:
-    static constexpr flnum gainAdjustment = 0.2;
-    static constexpr flnum clippingValue = 2.0;
+    static constexpr SampleType gainAdjustment = 0.2;
+    static constexpr SampleType clippingValue = 2.0;
+    // Below this difference of the inputs, ADAA falls back to the clipper
+    // at the midpoint to avoid dividing by almost 0
+    static constexpr double adaaEpsilon = 1e-5;
+
+    // ADAA runs in double because F (x[n]) - F (x[n - 1]) cancels a lot
+    struct AdaaState
+    {
+        double prevInput = 0.0;
+        double prevAntiderivative = 0.0;
+    };
+
     const IMasterParams* const p;
+    int numChannels;
+    std::vector<AdaaState> adaaStates;
+    SampleType gain;
+    bool isGainInitialized;
+    // The ramp and the mode of the current block
+    SampleType startGain;
+    SampleType gainStep;
+    bool isSoftClipOn;
+
+    // Sample `i` is multiplied by `startGain + gainStep * (offset + i + 1)`
+    static void hardClipBlock (SampleType* data, int numSamples, int offset, SampleType startGain, SampleType gainStep)
+    {
+        int i = 0;
+#if OS251_HAS_SSE2
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            const __m128 min4 = _mm_set1_ps (-clippingValue);
+            const __m128 max4 = _mm_set1_ps (clippingValue);
+            const __m128 startGain4 = _mm_set1_ps (startGain);
+            const __m128 gainStep4 = _mm_set1_ps (gainStep);
+            const __m128 four = _mm_set1_ps (4.0f);
+            const float firstStep = static_cast<float> (offset + 1);
+            __m128 step4 = _mm_setr_ps (firstStep, firstStep + 1.0f, firstStep + 2.0f, firstStep + 3.0f);
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                const __m128 gain4 = _mm_add_ps (startGain4, _mm_mul_ps (gainStep4, step4));
+                const __m128 val4 = _mm_mul_ps (_mm_loadu_ps (data + i), gain4);
+                _mm_storeu_ps (data + i, _mm_min_ps (_mm_max_ps (val4, min4), max4));
+                step4 = _mm_add_ps (step4, four);
+            }
+        }
+#endif
+        for (; i < numSamples; ++i)
+        {
+            const SampleType sampleGain = startGain + gainStep * static_cast<SampleType> (offset + i + 1);
+            data[i] = std::clamp (data[i] * sampleGain, -clippingValue, clippingValue);
+        }
+    }
+
+    static void softClipBlock (SampleType* data, int numSamples, int offset, SampleType startGain, SampleType gainStep, AdaaState& state)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const SampleType sampleGain = startGain + gainStep * static_cast<SampleType> (offset + i + 1);
+            const double input = static_cast<double> (data[i] * sampleGain);
+            const double antiderivative = softClipAntiderivative (input);
+            const double diff = input - state.prevInput;
+            const double output = std::abs (diff) < adaaEpsilon
+                                      ? softClip ((input + state.prevInput) / 2.0)
+                                      : (antiderivative - state.prevAntiderivative) / diff;
+            state.prevInput = input;
+            state.prevAntiderivative = antiderivative;
+            data[i] = static_cast<SampleType> (output);
+        }
+    }
+
+    static double softClip (double x)
+    {
+        return clippingValue * std::tanh (x / clippingValue);
+    }
+
+    // Antiderivative of softClip()
+    static double softClipAntiderivative (double x)
+    {
+        // log (cosh (u)) = |u| + log (1 + exp (-2|u|)) - log (2) doesn't overflow
+        const double u = std::abs (x / clippingValue);
+        constexpr double log2 = 0.69314718055994531;
+        return clippingValue * clippingValue * (u + std::log1p (std::exp (-2.0 * u)) - log2);
+    }
 };
 } // namespace onsen
@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+
+   Modulation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DspCommon.h"
+#include <array>
+
+namespace onsen
+{
+//==============================================================================
+// How often a modulation destination is evaluated
+enum class ModRate
+{
+    audio, // Every sample
+    control // Once per control interval, interpolated in between
+};
+
+enum class ModSource
+{
+    lfo,
+    envelope
+};
+static constexpr int numModSources = 2;
+
+enum class ModDestination
+{
+    pitch,
+    filterFreq,
+    shape
+};
+static constexpr int numModDestinations = 3;
+
+// Values of all the sources at a sample, indexed by ModSource
+template <typename SampleType>
+using ModSourceValues = std::array<SampleType, numModSources>;
+
+//==============================================================================
+// Modulation depth for each pair of source and destination.
+// compile() collects the routes with non-zero depth, so the per-sample path
+// only loops over the routes which are used.
+// It doesn't allocate, so it can be compiled on the audio thread.
+class ModulationMatrix
+{
+public:
+    struct Route
+    {
+        ModSource source;
+        flnum depth;
+    };
+
+    ModulationMatrix()
+        : depths(),
+          routes(),
+          numRoutes()
+    {
+    }
+
+    void setDepth (ModSource source, ModDestination destination, flnum depth)
+    {
+        depths[index (destination)][index (source)] = depth;
+    }
+
+    flnum getDepth (ModSource source, ModDestination destination) const
+    {
+        return depths[index (destination)][index (source)];
+    }
+
+    void compile()
+    {
+        for (int d = 0; d < numModDestinations; ++d)
+        {
+            numRoutes[d] = 0;
+            for (int s = 0; s < numModSources; ++s)
+            {
+                if (depths[d][s] != 0.0)
+                {
+                    routes[d][numRoutes[d]++] = { static_cast<ModSource> (s), depths[d][s] };
+                }
+            }
+        }
+    }
+
+    bool hasRoutes (ModDestination destination) const
+    {
+        return numRoutes[index (destination)] > 0;
+    }
+
+    template <typename SampleType>
+    SampleType modulate (ModDestination destination, const ModSourceValues<SampleType>& sources) const
+    {
+        const int d = index (destination);
+        SampleType sum = 0.0;
+        for (int i = 0; i < numRoutes[d]; ++i)
+        {
+            sum += routes[d][i].depth * sources[index (routes[d][i].source)];
+        }
+        return sum;
+    }
+
+private:
+    std::array<std::array<flnum, numModSources>, numModDestinations> depths;
+    // Only the first numRoutes[destination] routes are valid
+    std::array<std::array<Route, numModSources>, numModDestinations> routes;
+    std::array<int, numModDestinations> numRoutes;
+
+    template <typename Enum>
+    static constexpr int index (Enum e)
+    {
+        return static_cast<int> (e);
+    }
+};
+
+//==============================================================================
+// A modulation value evaluated once per `interval` samples.
+// The samples in between get a linear ramp from the previous control point,
+// so the value lags by one interval. With an interval of 1 it just returns
+// the evaluated value every sample.
+// `Value` is SampleType or a struct with +, - and * by SampleType.
+template <typename SampleType, typename Value = SampleType>
+class ControlRateValue
+{
+public:
+    ControlRateValue()
+        : interval (1),
+          countdown (0),
+          target(),
+          delta(),
+          initialized (false)
+    {
+    }
+
+    // Changing the interval restarts the ramp from the next evaluated value
+    void setInterval (int _interval)
+    {
+        assert (_interval >= 1);
+        if (_interval == interval)
+        {
+            return;
+        }
+        interval = _interval;
+        reset();
+    }
+
+    int getInterval() const
+    {
+        return interval;
+    }
+
+    void reset()
+    {
+        countdown = 0;
+        initialized = false;
+    }
+
+    // `evaluate` is called only at the control points
+    template <typename Evaluate>
+    Value next (Evaluate evaluate)
+    {
+        if (interval == 1)
+        {
+            return evaluate();
+        }
+        if (countdown == 0)
+        {
+            const Value newTarget = evaluate();
+            delta = initialized ? (newTarget - target) * (SampleType (1) / interval) : Value {};
+            target = newTarget;
+            countdown = interval;
+            initialized = true;
+        }
+        --countdown;
+        // Exactly the target at the end of the ramp
+        return target - delta * static_cast<SampleType> (countdown);
+    }
+
+private:
+    int interval;
+    int countdown;
+    Value target;
+    Value delta;
+    bool initialized;
+};
+} // namespace onsen
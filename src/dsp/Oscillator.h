@@ -10,40 +10,64 @@
 
 #include "../synth/SynthParams.h"
 #include "DspCommon.h"
+#include "Phasor.h"
+#include <array>
 #include <random>
+#include <utility>
 
 namespace onsen
 {
 //==============================================================================
+template <typename SampleType>
 class Oscillator
 {
-    using flnum = float;
+    static constexpr SampleType pi = pi_v<SampleType>;
 
 public:
+    static constexpr int maxNumLanes = 8;
+
     Oscillator() = delete;
     Oscillator (IOscillatorParams* const oscillatorParams)
         : p (oscillatorParams),
-          randEngine (seedGen()),
+          randEngine (std::random_device()()),
           randDist (0.0, 1.0),
-          smoothedShape (0.0, 0.995)
+          smoothedShape (0.0, 0.995),
+          kernel (getKernel (allWaves | shaped))
     {
     }
 
     // Return oscillator voltage value.
-    // Angle is in radian.
-    flnum oscillatorVal (flnum angleRad, flnum shapeModulationAmount)
+    // The main waves are an octave above `phase`, and the sub square is at `phase`.
+    SampleType oscillatorVal (Phasor phase, SampleType shapeModulationAmount)
     {
-        const flnum firstAngleRad = angleRad;
-        const flnum secondAngleRad = shapePhase (angleRad * 2, shapeModulationAmount);
+        SampleType val;
+        (this->*kernel) (&phase, &val, 1, shapeModulationAmount);
+        return val;
+    }
 
-        flnum currentSample = 0.0;
-        currentSample += sinWave (secondAngleRad) * p->getSinGain();
-        currentSample += squareWave (secondAngleRad) * p->getSquareGain();
-        currentSample += sawWave (secondAngleRad) * p->getSawGain();
-        currentSample += squareWave (firstAngleRad) * p->getSubSquareGain();
-        currentSample += noiseWave() * p->getNoiseGain();
+    // oscillatorVal() of `numLanes` phases at once, e.g. the copies of unison.
+    // All the lanes share the shape.
+    void oscillatorVals (const Phasor* phases, SampleType* out, int numLanes, SampleType shapeModulationAmount)
+    {
+        assert (numLanes >= 1 && numLanes <= maxNumLanes);
+        (this->*kernel) (phases, out, numLanes, shapeModulationAmount);
+    }
 
-        return currentSample;
+    // Choose the kernel which computes only the waves with non-zero gain.
+    // Call it once per block. Until it's called, every wave is computed.
+    void selectKernel (bool isShapeModulated)
+    {
+        int mask = 0;
+        mask |= p->getSinGain() != 0.0 ? sin : 0;
+        mask |= p->getSquareGain() != 0.0 ? square : 0;
+        mask |= p->getSawGain() != 0.0 ? saw : 0;
+        mask |= p->getSubSquareGain() != 0.0 ? subSquare : 0;
+        mask |= p->getNoiseGain() != 0.0 ? noise : 0;
+        // The shape is skipped only while it stays at 0
+        const bool isShapeOff = p->getShape() == 0.0 && ! isShapeModulated
+                                && smoothedShape.isSettled() && smoothedShape.get() == 0.0;
+        mask |= isShapeOff ? 0 : shaped;
+        kernel = getKernel (mask);
     }
 
     void setCurrentPlaybackSampleRate (double sampleRate)
@@ -57,57 +81,149 @@ public:
     }
 
 private:
+    // Bits of a kernel mask
+    enum KernelFlag
+    {
+        sin = 1 << 0,
+        square = 1 << 1,
+        saw = 1 << 2,
+        subSquare = 1 << 3,
+        noise = 1 << 4,
+        shaped = 1 << 5,
+        allWaves = sin | square | saw | subSquare | noise,
+        numKernels = 1 << 6
+    };
+    using Kernel = void (Oscillator::*) (const Phasor*, SampleType*, int, SampleType);
+
     IOscillatorParams* const p;
-    std::random_device seedGen;
+    // std::random_device is only for the seed. It's kilobytes and would
+    // spread the voice's state over many cache lines as a member.
     std::default_random_engine randEngine;
     std::uniform_real_distribution<> randDist;
-    SmoothFlnum smoothedShape;
+    SmoothValue<SampleType> smoothedShape;
+    Kernel kernel;
 
-    static flnum wrapAngle (flnum angle)
+    template <int mask>
+    void kernelVals (const Phasor* phases, SampleType* out, int numLanes, SampleType shapeModulationAmount)
     {
-        while (angle > 2.0 * pi)
+        constexpr bool hasMainWave = (mask & (sin | square | saw)) != 0;
+        std::fill (out, out + numLanes, SampleType (0.0));
+        if constexpr (hasMainWave)
+        {
+            // Normalized phases in [0, 1]
+            std::array<SampleType, maxNumLanes> secondPhases;
+            if constexpr ((mask & shaped) != 0)
+            {
+                const SampleType shape = updateShape (shapeModulationAmount);
+                for (int i = 0; i < numLanes; ++i)
+                    secondPhases[i] = shapePhase (phases[i].doubled(), shape);
+            }
+            else
+            {
+                for (int i = 0; i < numLanes; ++i)
+                    secondPhases[i] = phases[i].doubled().template normalized<SampleType>();
+            }
+
+            if constexpr ((mask & sin) != 0)
+            {
+                std::array<SampleType, maxNumLanes> sines;
+                for (int i = 0; i < numLanes; ++i)
+                    sines[i] = 2.0 * pi * secondPhases[i];
+                DspMath::sinBlock (sines.data(), sines.data(), numLanes);
+                addWave (out, sines.data(), numLanes, p->getSinGain());
+            }
+            if constexpr ((mask & square) != 0)
+            {
+                std::array<SampleType, maxNumLanes> squares;
+                for (int i = 0; i < numLanes; ++i)
+                    squares[i] = squareWave (secondPhases[i]);
+                addWave (out, squares.data(), numLanes, p->getSquareGain());
+            }
+            if constexpr ((mask & saw) != 0)
+            {
+                std::array<SampleType, maxNumLanes> saws;
+                for (int i = 0; i < numLanes; ++i)
+                    saws[i] = sawWave (secondPhases[i]);
+                addWave (out, saws.data(), numLanes, p->getSawGain());
+            }
+        }
+        else if constexpr ((mask & shaped) != 0)
+        {
+            // Keep smoothing the shape for the waves which come back later
+            updateShape (shapeModulationAmount);
+        }
+        if constexpr ((mask & subSquare) != 0)
+        {
+            const SampleType gain = p->getSubSquareGain();
+            for (int i = 0; i < numLanes; ++i)
+                out[i] += subSquareWave (phases[i]) * gain;
+        }
+        if constexpr ((mask & noise) != 0)
         {
-            angle -= 2.0 * pi;
+            const SampleType gain = p->getNoiseGain();
+            for (int i = 0; i < numLanes; ++i)
+                out[i] += noiseWave() * gain;
         }
-        return angle;
+    }
+
+    static void addWave (SampleType* out, const SampleType* wave, int numLanes, SampleType gain)
+    {
+        for (int i = 0; i < numLanes; ++i)
+            out[i] += wave[i] * gain;
+    }
+
+    template <int... masks>
+    static constexpr std::array<Kernel, sizeof...(masks)> makeKernels (std::integer_sequence<int, masks...>)
+    {
+        return { &Oscillator::kernelVals<masks>... };
+    }
+
+    static Kernel getKernel (int mask)
+    {
+        // Every combination of the flags, generated at compile time
+        static constexpr auto kernels = makeKernels (std::make_integer_sequence<int, numKernels>());
+        return kernels[static_cast<size_t> (mask)];
     }
 
     // TODO: extract waveforms as function
+    // The phase of the waves is normalized to [0, 1].
 
-    static flnum sinWave (flnum angle)
+    static SampleType squareWave (SampleType phase)
     {
-        return std::sin (angle);
+        return phase < 0.5 ? 1.0 : -1.0;
     }
 
-    static flnum squareWave (flnum angle)
+    static SampleType sawWave (SampleType phase)
     {
-        return angle < pi ? 1.0 : -1.0;
+        return std::min<SampleType> (2.0 * phase, 2.0) - 1.0;
     }
 
-    static flnum sawWave (flnum angle)
+    static SampleType subSquareWave (Phasor phase)
     {
-        return std::min (2.0 * angle / (2.0 * pi), 2.0) - 1.0;
+        return phase.isFirstHalf() ? 1.0 : -1.0;
     }
 
-    flnum noiseWave()
+    SampleType noiseWave()
     {
         return randDist (randEngine);
     }
 
-    flnum shapePhase (flnum angle, flnum shapeModulationAmount)
+    SampleType updateShape (SampleType shapeModulationAmount)
     {
-        angle = wrapAngle (angle);
         smoothedShape.set (p->getShape() + shapeModulationAmount);
         smoothedShape.update();
-        flnum shape = std::clamp<flnum> (smoothedShape.get(), 0.0, 1.0);
-        flnum normalizedAngle = std::clamp (angle / (2.0 * pi), 0.0, 1.0);
-        flnum shaped = 2.0 * pi * (shape * map (normalizedAngle) + (1.0 - shape) * normalizedAngle);
-        return shaped;
+        return std::clamp<SampleType> (smoothedShape.get(), 0.0, 1.0);
+    }
+
+    SampleType shapePhase (Phasor phase, SampleType shape)
+    {
+        SampleType normalizedAngle = phase.normalized<SampleType>();
+        return shape * map (normalizedAngle) + (1.0 - shape) * normalizedAngle;
     }
 
-    flnum map (flnum in0to1)
+    SampleType map (SampleType in0to1)
     {
-        flnum out0to1 = in0to1 * in0to1 * in0to1 * in0to1 * in0to1 * in0to1 * in0to1 * in0to1;
+        SampleType out0to1 = in0to1 * in0to1 * in0to1 * in0to1 * in0to1 * in0to1 * in0to1 * in0to1;
         return out0to1;
     }
 };
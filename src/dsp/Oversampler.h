@@ -0,0 +1,197 @@
+/*
+  ==============================================================================
+
+   Oversampler
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DspCommon.h"
+#include <array>
+#include <vector>
+
+namespace onsen
+{
+//==============================================================================
+// 2:1 decimator with a half-band FIR filter in polyphase form.
+// Every other tap of a half-band filter is zero except the center one (0.5),
+// so the even input samples only go through a delay and the odd ones through
+// a symmetric FIR. It costs numCoeffs multiplications per output sample.
+template <typename SampleType, int numCoeffs>
+class HalfBandDecimator
+{
+public:
+    HalfBandDecimator() = delete;
+    HalfBandDecimator (const std::array<double, numCoeffs>& _coeffs)
+    {
+        for (int i = 0; i < numCoeffs; ++i)
+        {
+            coeffs[i] = static_cast<SampleType> (_coeffs[i]);
+        }
+        reset();
+    }
+
+    void reset()
+    {
+        evenHistory.fill (0.0);
+        oddHistory.fill (0.0);
+        evenPos = 0;
+        oddPos = 0;
+    }
+
+    // `in` has 2 * numOutputSamples samples.
+    // `out` can be `in` itself.
+    void process (const SampleType* in, SampleType* out, int numOutputSamples)
+    {
+        for (int i = 0; i < numOutputSamples; ++i)
+        {
+            push (evenHistory, evenPos, in[2 * i]);
+            push (oddHistory, oddPos, in[2 * i + 1]);
+
+            // odd[0] is the newest sample
+            const SampleType* odd = &oddHistory[oddPos];
+            SampleType acc = 0.0;
+            for (int k = 0; k < numCoeffs; ++k)
+            {
+                acc += coeffs[k] * (odd[numCoeffs - 1 - k] + odd[numCoeffs + k]);
+            }
+            out[i] = acc + static_cast<SampleType> (0.5) * evenHistory[evenPos + numCoeffs - 1];
+        }
+    }
+
+private:
+    static constexpr int evenLength = numCoeffs;
+    static constexpr int oddLength = 2 * numCoeffs;
+
+    std::array<SampleType, numCoeffs> coeffs;
+    // The histories are written twice so that the latest `length` samples
+    // are always contiguous from `pos`.
+    std::array<SampleType, 2 * evenLength> evenHistory;
+    std::array<SampleType, 2 * oddLength> oddHistory;
+    int evenPos;
+    int oddPos;
+
+    template <size_t size>
+    static void push (std::array<SampleType, size>& history, int& pos, SampleType val)
+    {
+        constexpr int length = static_cast<int> (size / 2);
+        pos = (pos == 0 ? length : pos) - 1;
+        history[pos] = val;
+        history[pos + length] = val;
+    }
+};
+
+//==============================================================================
+// It brings buses rendered at 2x or 4x of the sample rate back to the
+// sample rate. 4x goes through two half-band stages.
+// Each of `numChannels` channels has its own filter state.
+template <typename SampleType>
+class Oversampler
+{
+public:
+    static constexpr int maxFactor = 4;
+
+    explicit Oversampler (int numChannels = 1)
+        : factor (1),
+          decimators (numChannels)
+    {
+    }
+
+    // `newFactor` should be 1, 2 or 4.
+    void setFactor (int newFactor)
+    {
+        assert (newFactor == 1 || newFactor == 2 || newFactor == 4);
+        if (newFactor == factor)
+        {
+            return;
+        }
+        factor = newFactor;
+        reset();
+    }
+
+    int getFactor() const
+    {
+        return factor;
+    }
+
+    // Group delay of the decimation at `factor` in samples at the sample rate.
+    // A stage with n coefficients delays by 2n - 2 samples at its input rate
+    // from the even input sample of each output, so it's 15 samples at 2x and
+    // 17.5 samples at 4x.
+    static double getLatency (int factor)
+    {
+        const double from2xTo1xLatency = (2.0 * from2xTo1xCoeffs.size() - 2.0) / 2.0;
+        const double from4xTo2xLatency = (2.0 * from4xTo2xCoeffs.size() - 2.0) / 4.0;
+        return factor == 4 ? from2xTo1xLatency + from4xTo2xLatency
+               : factor == 2 ? from2xTo1xLatency
+                             : 0.0;
+    }
+
+    void reset()
+    {
+        for (auto& decimator : decimators)
+        {
+            decimator.from4xTo2x.reset();
+            decimator.from2xTo1x.reset();
+        }
+    }
+
+    // Decimate `numSamples * factor` samples of `data` in place to the first
+    // `numSamples` samples
+    void decimate (int channel, SampleType* data, int numSamples)
+    {
+        assert (factor > 1);
+        Decimator& decimator = decimators[channel];
+        if (factor == 4)
+        {
+            decimator.from4xTo2x.process (data, data, numSamples * 2);
+        }
+        decimator.from2xTo1x.process (data, data, numSamples);
+    }
+
+private:
+    // Kaiser windowed half-band filters. Only the odd taps from the center.
+    // 4x -> 2x: Passband 0.1 fs, stopband 0.4 fs (-67 dB). The wide transition
+    // band is enough because the next stage removes [0.25 fs, 0.5 fs].
+    static constexpr std::array<double, 6> from4xTo2xCoeffs {
+        0.3124060254865858,
+        -0.089227570631373224,
+        0.038805317103309846,
+        -0.016461297233172047,
+        0.0057882599378874036,
+        -0.0013107346632378024
+    };
+    // 2x -> 1x: Passband 0.2 fs, stopband 0.3 fs (-82 dB).
+    static constexpr std::array<double, 16> from2xTo1xCoeffs {
+        0.31715980024659091,
+        -0.10266803925791501,
+        0.058076844075388948,
+        -0.037943812175422816,
+        0.026161212654794219,
+        -0.018361831818429146,
+        0.012871603628119239,
+        -0.0089004950623466118,
+        0.006012201477612545,
+        -0.0039313925570002824,
+        0.0024640125596369299,
+        -0.0014619074880941804,
+        0.00080668247700204699,
+        -0.00040230113065159602,
+        0.00017157420463027366,
+        -5.4151833915521818e-05
+    };
+
+    struct Decimator
+    {
+        Decimator() : from4xTo2x (from4xTo2xCoeffs), from2xTo1x (from2xTo1xCoeffs) {}
+
+        HalfBandDecimator<SampleType, 6> from4xTo2x;
+        HalfBandDecimator<SampleType, 16> from2xTo1x;
+    };
+
+    int factor;
+    std::vector<Decimator> decimators;
+};
+} // namespace onsen
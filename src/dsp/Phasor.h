@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+   Phasor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DspCommon.h"
+#include <cstdint>
+
+namespace onsen
+{
+//==============================================================================
+// Phase of an oscillator in 32-bit fixed point. One cycle is 2^32, so the
+// phase wraps around by the unsigned overflow and its resolution doesn't get
+// worse over long notes like a float angle does.
+// The top bits of the phase index a wavetable directly.
+class Phasor
+{
+public:
+    using Phase = std::uint32_t;
+    static constexpr double phasesPerCycle = 4294967296.0; // 2^32
+
+    Phasor() : phase (0) {}
+    explicit Phasor (Phase _phase) : phase (_phase) {}
+
+    static Phasor fromCycles (double cycles)
+    {
+        return Phasor (toIncrement (cycles - std::floor (cycles)));
+    }
+
+    static Phasor fromRadians (double angleRad)
+    {
+        return fromCycles (angleRad / DspMath::twoPi<double>);
+    }
+
+    // Negative `cyclesPerSample` moves the phase backwards
+    static Phase toIncrement (double cyclesPerSample)
+    {
+        return static_cast<Phase> (static_cast<std::int64_t> (std::floor (cyclesPerSample * phasesPerCycle + 0.5)));
+    }
+
+    static Phase radiansToIncrement (double angleDeltaRad)
+    {
+        return toIncrement (angleDeltaRad / DspMath::twoPi<double>);
+    }
+
+    // Shortest signed angle from `from` to `to` in radian
+    static double radiansBetween (Phasor from, Phasor to)
+    {
+        return static_cast<std::int32_t> (to.phase - from.phase) * (DspMath::twoPi<double> / phasesPerCycle);
+    }
+
+    Phase get() const
+    {
+        return phase;
+    }
+
+    void advance (Phase increment)
+    {
+        phase += increment;
+    }
+
+    // In [0, 1)
+    template <typename T>
+    T normalized() const
+    {
+        const double cycles = phase * (1.0 / phasesPerCycle);
+        if constexpr (std::is_same_v<T, float>)
+        {
+            // Rounding to float can make it 1
+            constexpr float maxBelowOne = 1.0f - std::numeric_limits<float>::epsilon() / 2;
+            return std::min (static_cast<float> (cycles), maxBelowOne);
+        }
+        else
+        {
+            return static_cast<T> (cycles);
+        }
+    }
+
+    // In [0, 2 * pi]
+    template <typename T>
+    T radians() const
+    {
+        return normalized<T>() * DspMath::twoPi<T>;
+    }
+
+    // The phase of the octave above
+    Phasor doubled() const
+    {
+        return Phasor (phase << 1);
+    }
+
+    bool isFirstHalf() const
+    {
+        return phase < 0x80000000u;
+    }
+
+    // Index of a table with 2^numBits entries
+    template <int numBits>
+    int index() const
+    {
+        static_assert (numBits > 0 && numBits < 32);
+        return static_cast<int> (phase >> (32 - numBits));
+    }
+
+    // Position between index<numBits>() and the next entry in [0, 1)
+    template <int numBits, typename T>
+    T fraction() const
+    {
+        static_assert (numBits > 0 && numBits < 32);
+        return Phasor (phase << numBits).normalized<T>();
+    }
+
+private:
+    Phase phase;
+};
+} // namespace onsen
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+   Post effects
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../services/Trace.h"
+#include "../synth/SynthParams.h"
+#include "BufferArena.h"
+#include "Chorus.h"
+#include "DspCommon.h"
+#include "Hpf.h"
+#include "IAudioBuffer.h"
+#include "MasterVolume.h"
+#include <algorithm>
+
+namespace onsen
+{
+//==============================================================================
+// The effects after the voices: HPF, chorus and master volume.
+// Instead of running each effect over the whole block, the fused pass runs
+// all of them over a sub-block at a time, so the samples are still in L1
+// for the next effect. The parameters are read once per block, so the
+// output is the same as the separate chain's.
+template <typename SampleType>
+class PostEffects
+{
+public:
+    static constexpr int subBlockSize = 64;
+
+    PostEffects() = delete;
+    PostEffects (IHpfParams* const hpfParams, IChorusParams* const chorusParams, IMasterParams* const masterParams, int numChannels)
+        : p (chorusParams),
+          hpf (hpfParams, numChannels),
+          chorus(),
+          masterVolume (masterParams, numChannels)
+    {
+    }
+
+    void render (IAudioBuffer<SampleType>* outputAudio, int startSample, int numSamples)
+    {
+        OS251_TRACE_SCOPE ("PostEffects::render");
+        // The loop is chosen per block from the enabled effects
+        if (p->getChorusOn())
+            renderFused<true> (outputAudio, startSample, numSamples);
+        else
+            renderFused<false> (outputAudio, startSample, numSamples);
+    }
+
+    void setCurrentPlaybackSampleRate (double sampleRate)
+    {
+        hpf.setCurrentPlaybackSampleRate (sampleRate);
+        chorus.setCurrentPlaybackSampleRate (sampleRate);
+    }
+
+    // The owner of `arena` places the buffers with placeBuffers() after
+    // setCurrentPlaybackSampleRate()
+    void useBufferArena (BufferArena& arena)
+    {
+        hpf.useBufferArena (arena);
+        chorus.useBufferArena (arena);
+    }
+
+    void placeBuffers (BufferArena::Placer& placer)
+    {
+        hpf.placeBuffers (placer);
+        chorus.placeBuffers (placer);
+    }
+
+private:
+    const IChorusParams* const p;
+    Hpf<SampleType> hpf;
+    Chorus<SampleType> chorus;
+    MasterVolume<SampleType> masterVolume;
+
+    template <bool isChorusOn>
+    void renderFused (IAudioBuffer<SampleType>* outputAudio, int startSample, int numSamples)
+    {
+        // The ramps of both effects span the same samples, and never go past the buffer
+        numSamples = std::min (outputAudio->getNumSamples(), startSample + numSamples) - startSample;
+        hpf.prepareBlock (numSamples);
+        masterVolume.prepareBlock (numSamples);
+
+        for (int offset = 0; offset < numSamples; offset += subBlockSize)
+        {
+            const int subBlockStart = startSample + offset;
+            const int subBlockNumSamples = std::min (subBlockSize, numSamples - offset);
+            hpf.process (outputAudio, subBlockStart, subBlockNumSamples);
+            if constexpr (isChorusOn)
+                chorus.render (outputAudio, subBlockStart, subBlockNumSamples);
+            masterVolume.process (outputAudio, subBlockStart, subBlockNumSamples, offset);
+        }
+    }
+};
+} // namespace onsen
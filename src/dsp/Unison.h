@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+
+   Unison
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DspCommon.h"
+#include "Phasor.h"
+#include <array>
+
+namespace onsen
+{
+//==============================================================================
+// Phases of up to maxNumVoices detuned copies of a voice's oscillator.
+// The copies are kept as lanes of fixed-size arrays, so the oscillator can
+// compute all of them in one pass instead of running one voice per copy.
+// The copies are detuned and panned symmetrically around the note: the
+// lowest one is on the left and the highest one is on the right.
+template <typename SampleType>
+class Unison
+{
+public:
+    static constexpr int maxNumVoices = 8;
+    // Detune of the outermost copies when the detune is 1
+    static constexpr double maxDetuneCents = 50.0;
+
+    Unison()
+        : numVoices (1),
+          detune (0.0),
+          spread (0.0),
+          incrementsAngleDelta (0.0)
+    {
+        // Start the copies at different phases so that they don't sum up
+        // to a louder single wave at the beginning of the note
+        constexpr double goldenRatioFraction = 0.6180339887498949;
+        for (int i = 0; i < maxNumVoices; ++i)
+        {
+            phases[i] = Phasor::fromCycles (i * goldenRatioFraction);
+        }
+        updateLanes();
+        updateIncrements (0.0);
+    }
+
+    // `_detune` and `_spread` are in [0, 1]
+    void set (int _numVoices, SampleType _detune, SampleType _spread)
+    {
+        assert (_numVoices >= 1 && _numVoices <= maxNumVoices);
+        if (_numVoices == numVoices && _detune == detune && _spread == spread)
+        {
+            return;
+        }
+        numVoices = _numVoices;
+        detune = _detune;
+        spread = _spread;
+        updateLanes();
+        updateIncrements (incrementsAngleDelta);
+    }
+
+    int getNumVoices() const
+    {
+        return numVoices;
+    }
+
+    // Whether the copies are panned. Otherwise mixMono() is enough.
+    bool isStereo() const
+    {
+        return numVoices > 1 && spread != 0.0;
+    }
+
+    const Phasor* getPhases() const
+    {
+        return phases.data();
+    }
+
+    // Advance each copy by `angleDeltaRad` of the note times its detune ratio
+    void advance (double angleDeltaRad)
+    {
+        // The increments are converted only when the pitch moves, so usually
+        // once per note and the loop is only integer additions
+        if (angleDeltaRad != incrementsAngleDelta)
+        {
+            updateIncrements (angleDeltaRad);
+        }
+        for (int i = 0; i < numVoices; ++i)
+        {
+            phases[i].advance (increments[i]);
+        }
+    }
+
+    // `vals` has a value for each copy
+    SampleType mixMono (const SampleType* vals) const
+    {
+        SampleType sum = 0.0;
+        for (int i = 0; i < numVoices; ++i)
+        {
+            sum += vals[i];
+        }
+        return sum * gain;
+    }
+
+    void mixStereo (const SampleType* vals, SampleType& left, SampleType& right) const
+    {
+        SampleType sumLeft = 0.0;
+        SampleType sumRight = 0.0;
+        for (int i = 0; i < numVoices; ++i)
+        {
+            sumLeft += vals[i] * leftGains[i];
+            sumRight += vals[i] * rightGains[i];
+        }
+        left = sumLeft;
+        right = sumRight;
+    }
+
+private:
+    int numVoices;
+    SampleType detune;
+    SampleType spread;
+    std::array<Phasor, maxNumVoices> phases;
+    std::array<double, maxNumVoices> ratios;
+    // Phase increments of the copies at `incrementsAngleDelta`
+    std::array<Phasor::Phase, maxNumVoices> increments;
+    double incrementsAngleDelta;
+    // Keep the power of the uncorrelated copies same as a single voice
+    SampleType gain;
+    std::array<SampleType, maxNumVoices> leftGains;
+    std::array<SampleType, maxNumVoices> rightGains;
+
+    void updateLanes()
+    {
+        gain = static_cast<SampleType> (1.0 / std::sqrt (static_cast<double> (numVoices)));
+        for (int i = 0; i < maxNumVoices; ++i)
+        {
+            // In [-1, 1] from the lowest copy to the highest one
+            const double offset = numVoices == 1 ? 0.0 : 2.0 * i / (numVoices - 1) - 1.0;
+            ratios[i] = std::exp2 (offset * detune * maxDetuneCents / 1200.0);
+            // Equal power panning which is 1 for both channels at the center
+            const double panAngle = (offset * spread + 1.0) * DspMath::twoPi<double> / 8.0;
+            leftGains[i] = static_cast<SampleType> (std::cos (panAngle) * std::sqrt (2.0) * gain);
+            rightGains[i] = static_cast<SampleType> (std::sin (panAngle) * std::sqrt (2.0) * gain);
+        }
+    }
+
+    void updateIncrements (double angleDeltaRad)
+    {
+        incrementsAngleDelta = angleDeltaRad;
+        const double cyclesPerSample = angleDeltaRad / DspMath::twoPi<double>;
+        // The copies above `numVoices` get theirs from set() when they're used
+        for (int i = 0; i < numVoices; ++i)
+        {
+            increments[i] = Phasor::toIncrement (cyclesPerSample * ratios[i]);
+        }
+    }
+};
+} // namespace onsen
@@ -1,7 +1,6 @@
 import Menu from './Menu'
 import SliderModule from './SliderModule'
 import ButtonModule from './ButtonModule'
-import DummyModule from './DummyModule'
 
 import React, { Component, ReactNode } from 'react'
 
@@ -181,7 +180,10 @@ class App extends Component<{}, IState> {
                 paramId="lfoDelay"
                 paramLabel="LFO Delay"
               />
-              <DummyModule />
+              <SliderModule
+                paramId="oversampling"
+                paramLabel="Oversampling"
+              />
               <SliderModule
                 paramId="hpfFreq"
                 paramLabel="HPF Freq"
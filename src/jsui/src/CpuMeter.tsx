@@ -0,0 +1,78 @@
+import React, { Component, ReactNode } from 'react'
+import {
+  EventBridge,
+  Text,
+  View
+} from 'react-juce'
+import { textColor } from './Colors'
+
+interface IState {
+  averageLoad: number
+  peakLoad: number
+  numActiveVoices: number
+  numXrunRisks: number
+}
+
+class CpuMeter extends Component<{}, IState> {
+  constructor (props: {}) {
+    super(props)
+
+    this._onCpuLoadChange = this._onCpuLoadChange.bind(this)
+
+    this.state = {
+      averageLoad: 0,
+      peakLoad: 0,
+      numActiveVoices: 0,
+      numXrunRisks: 0
+    }
+  }
+
+  componentDidMount (): void {
+    EventBridge.addListener('cpuLoadChange', this._onCpuLoadChange)
+  }
+
+  componentWillUnmount (): void {
+    EventBridge.removeListener('cpuLoadChange', this._onCpuLoadChange)
+  }
+
+  _onCpuLoadChange (
+    averageLoad: number,
+    peakLoad: number,
+    numActiveVoices: number,
+    numXrunRisks: number): void {
+    this.setState({
+      averageLoad: averageLoad,
+      peakLoad: peakLoad,
+      numActiveVoices: numActiveVoices,
+      numXrunRisks: numXrunRisks
+    })
+  }
+
+  render (): ReactNode {
+    const { averageLoad, peakLoad, numActiveVoices, numXrunRisks } = this.state
+    let voices = `Voices ${numActiveVoices}`
+    if (numXrunRisks > 0) {
+      voices += ` Xrun ${numXrunRisks}`
+    }
+    return (
+      <View {...this.props}>
+        <Text {...styles.labelText}>
+          {`CPU ${averageLoad.toFixed(0)}% / ${peakLoad.toFixed(0)}%`}
+        </Text>
+        <Text {...styles.labelText}>
+          {voices}
+        </Text>
+      </View>
+    )
+  }
+}
+
+const styles = {
+  labelText: {
+    color: textColor,
+    fontSize: 10.0,
+    lineSpacing: 1.2
+  }
+}
+
+export default CpuMeter
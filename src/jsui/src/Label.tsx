@@ -1,12 +1,10 @@
 import React, { Component, ReactNode } from 'react'
 import {
-  EventBridge,
   Text,
   View
 } from 'react-juce'
 import { textColor } from './Colors'
-
-import type { ParamValue } from './ParamValueType'
+import ParameterValueStore from './ParameterValueStore'
 
 interface IProps {
   paramId?: string
@@ -28,22 +26,23 @@ class Label extends Component<IProps, IState> {
   }
 
   componentDidMount (): void {
-    EventBridge.addListener('parameterValueChange', this._onParameterValueChange)
+    ParameterValueStore.addListener(
+      ParameterValueStore.CHANGE_EVENT,
+      this._onParameterValueChange
+    )
   }
 
   componentWillUnmount (): void {
-    EventBridge.removeListener('parameterValueChange', this._onParameterValueChange)
+    ParameterValueStore.removeListener(
+      ParameterValueStore.CHANGE_EVENT,
+      this._onParameterValueChange
+    )
   }
 
-  _onParameterValueChange (
-    _index: number,
-    paramId: string,
-    _defaultValue: ParamValue,
-    _currentValue: ParamValue,
-    stringValue: string): void {
+  _onParameterValueChange (paramId: string): void {
     if (paramId === this.props.paramId) {
       this.setState({
-        label: stringValue
+        label: ParameterValueStore.getParameterState(paramId).stringValue
       })
     }
   }
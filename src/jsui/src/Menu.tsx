@@ -5,6 +5,7 @@ import {
   View
 } from 'react-juce'
 import { textColor } from './Colors'
+import CpuMeter from './CpuMeter'
 import { PresetManager } from './PresetManager'
 
 class Menu extends Component {
@@ -16,6 +17,7 @@ class Menu extends Component {
             OS-251
           </Text>
           <PresetManager {...styles.preset_manager}/>
+          <CpuMeter {...styles.cpu_meter}/>
         </View>
       </View>
     )
@@ -45,6 +47,14 @@ const styles = {
     width: 360,
     marginTop: 1,
     marginLeft: 300
+  },
+  cpu_meter: {
+    position: 'absolute',
+    flexDirection: 'column',
+    right: 0,
+    top: 2,
+    width: 80,
+    height: 28
   }
 }
 
@@ -18,9 +18,9 @@ class ParameterValueStore extends EventEmitter {
     this.CHANGE_EVENT = 'change'
 
     this.setMaxListeners(100)
-    this._onParameterValueChange = this._onParameterValueChange.bind(this)
+    this._onParameterValuesChange = this._onParameterValuesChange.bind(this)
 
-    EventBridge.addListener('parameterValueChange', this._onParameterValueChange)
+    EventBridge.addListener('parameterValuesChange', this._onParameterValuesChange)
 
     this.state = {}
   }
@@ -33,6 +33,15 @@ class ParameterValueStore extends EventEmitter {
     return this.state[paramId]
   }
 
+  /** The editor sends all changes in a frame at once. Each change is
+   *  [index, paramId, defaultValue, currentValue, stringValue].
+   */
+  _onParameterValuesChange (changes: any[][]): void {
+    for (const change of changes) {
+      this._onParameterValueChange(change[0], change[1], change[2], change[3], change[4])
+    }
+  }
+
   _onParameterValueChange (
     index: number,
     paramId: string,
@@ -0,0 +1,26 @@
+/*
+  ==============================================================================
+
+   Chorus Parameters Mock
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ChorusParams.h"
+
+namespace onsen
+{
+//==============================================================================
+class ChorusParamsMock : public IChorusParams
+{
+public:
+    bool getChorusOn() const override
+    {
+        return chorusOn;
+    }
+
+    bool chorusOn = true;
+};
+} // namespace onsen
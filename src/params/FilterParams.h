@@ -32,8 +32,9 @@ public:
     }
     flnum getControlledFrequency (flnum controlVal) const override
     {
+        // It's called for every sample, so use exp2 instead of pow.
         flnum newFrequency = std::clamp<flnum> (frequencyVal + controlVal, 0.0, 1.0);
-        return lowestFreqVal() * std::pow (freqBaseNumber(), newFrequency);
+        return lowestFreqVal() * DspMath::exp2 (newFrequency * log2FreqBaseNumber());
     }
     void setFrequencyPtr (const std::atomic<flnum>* _frequency)
     {
@@ -77,6 +78,10 @@ public:
     {
         return 1000.0;
     }
+    static constexpr flnum log2FreqBaseNumber()
+    {
+        return 9.965784284662087; // log2 (freqBaseNumber())
+    }
     // Resonance
     static constexpr flnum lowestResVal()
     {
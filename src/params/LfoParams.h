@@ -34,7 +34,7 @@ public:
     // Returns LFO rate in [Hz].
     flnum getRate() const override
     {
-        return lowestRateVal() * pow (rateBaseNumber(), rateVal);
+        return lowestRateVal() * DspMath::exp2 (rateVal * log2RateBaseNumber());
     }
     void setRatePtr (const std::atomic<flnum>* _rate)
     {
@@ -135,6 +135,10 @@ public:
     {
         return 500.0;
     }
+    static constexpr flnum log2RateBaseNumber()
+    {
+        return 8.965784284662087; // log2 (rateBaseNumber())
+    }
 
     // Synced rate
     static constexpr int lowestRateSyncNumeratorVal()
@@ -24,6 +24,7 @@ public:
     virtual flnum getMasterFineTune() const = 0;
     virtual flnum getPortamento() const = 0;
     virtual flnum getMasterVolume() const = 0;
+    virtual bool getSoftClipOn() const = 0;
 };
 //==============================================================================
 class MasterParams : public IMasterParams
@@ -34,6 +35,8 @@ public:
     static constexpr int maxOctaveTuneVal = 3; // unit is [octave]
     static constexpr int maxSemitoneTuneVal = 12; // unit is [semitone] or [st]
     static constexpr int maxNumVoices = 24;
+    // Oversampling factor is 2 ^ [0, maxOversamplingFactorLog2]
+    static constexpr int maxOversamplingFactorLog2 = 2;
 
     //==============================================================================
     bool getEnvForAmpOn() const override
@@ -106,6 +109,15 @@ public:
         masterVolume = _masterVolume;
         masterVolumeVal = *masterVolume;
     }
+    bool getSoftClipOn() const override
+    {
+        return softClipOnVal > 0.5;
+    }
+    void setSoftClipOnPtr (const std::atomic<flnum>* _softClipOn)
+    {
+        softClipOn = _softClipOn;
+        softClipOnVal = *softClipOn;
+    }
     void parameterChanged()
     {
         envForAmpOnVal = *envForAmpOn;
@@ -115,6 +127,7 @@ public:
         masterFineTuneVal = *masterFineTune;
         portamentoVal = *portamento;
         masterVolumeVal = *masterVolume;
+        softClipOnVal = *softClipOn;
     }
     flnum getPitchBendWidthInFreqRatio() const
     {
@@ -125,9 +138,8 @@ public:
     flnum getFreqRatio()
     {
         // Return frequency ratio of pitch tuning
-        return std::pow (
-            2.0,
-            getMasterOctaveTune() + (getMasterSemitoneTune() + getMasterFineTune()) / 12.0);
+        return DspMath::exp2 (
+            getMasterOctaveTune() + (getMasterSemitoneTune() + getMasterFineTune()) / flnum (12.0));
     }
 
 private:
@@ -138,6 +150,7 @@ private:
     const std::atomic<flnum>* masterFineTune {};
     const std::atomic<flnum>* portamento {};
     const std::atomic<flnum>* masterVolume {};
+    const std::atomic<flnum>* softClipOn {};
 
     flnum envForAmpOnVal = 1.0;
     flnum pitchBendWidthVal = 12; // Unit is [semitone]
@@ -146,5 +159,6 @@ private:
     flnum masterFineTuneVal = 0.5;
     flnum portamentoVal = 0.0;
     flnum masterVolumeVal = 0.5;
+    flnum softClipOnVal = 0.0;
 };
 } // namespace onsen
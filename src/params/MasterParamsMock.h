@@ -37,6 +37,7 @@ struct MasterParamsMock : public IMasterParams
     flnum getPortamento() const override { return portamento; }
     flnum getMasterVolume() const override { return masterVolume; }
     void setMasterVolume (flnum _masterVolume) { masterVolume = _masterVolume; }
+    bool getSoftClipOn() const override { return softClipOn; }
 
     bool envForAmpOn;
     flnum pitchBendWidth;
@@ -45,6 +46,7 @@ struct MasterParamsMock : public IMasterParams
     flnum masterFineTune;
     flnum portamento;
     flnum masterVolume;
+    bool softClipOn = false;
 };
 
 } // namespace onsen
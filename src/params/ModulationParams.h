@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+   Modulation Parameters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../dsp/DspCommon.h"
+#include "../dsp/Modulation.h"
+#include <atomic>
+
+namespace onsen
+{
+//==============================================================================
+class IModulationParams
+{
+public:
+    virtual int getControlInterval() const = 0;
+    virtual ModRate getPitchModRate() const = 0;
+    virtual ModRate getFilterModRate() const = 0;
+    virtual ModRate getShapeModRate() const = 0;
+    virtual flnum getEnvPitch() const = 0;
+    virtual flnum getEnvShape() const = 0;
+};
+
+//==============================================================================
+class ModulationParams : public IModulationParams
+{
+public:
+    // Control interval is 2 ^ [minControlIntervalLog2, maxControlIntervalLog2] samples
+    static constexpr int minControlIntervalLog2 = 3;
+    static constexpr int maxControlIntervalLog2 = 5;
+
+    //==============================================================================
+    int getControlInterval() const override
+    {
+        return 1 << DspUtil::mapFlnumToInt (controlIntervalVal, 0.0, 1.0, minControlIntervalLog2, maxControlIntervalLog2);
+    }
+    void setControlIntervalPtr (const std::atomic<flnum>* _controlInterval)
+    {
+        controlInterval = _controlInterval;
+        controlIntervalVal = *controlInterval;
+    }
+    ModRate getPitchModRate() const override
+    {
+        return toModRate (pitchControlRateVal);
+    }
+    void setPitchControlRatePtr (const std::atomic<flnum>* _pitchControlRate)
+    {
+        pitchControlRate = _pitchControlRate;
+        pitchControlRateVal = *pitchControlRate;
+    }
+    ModRate getFilterModRate() const override
+    {
+        return toModRate (filterControlRateVal);
+    }
+    void setFilterControlRatePtr (const std::atomic<flnum>* _filterControlRate)
+    {
+        filterControlRate = _filterControlRate;
+        filterControlRateVal = *filterControlRate;
+    }
+    ModRate getShapeModRate() const override
+    {
+        return toModRate (shapeControlRateVal);
+    }
+    void setShapeControlRatePtr (const std::atomic<flnum>* _shapeControlRate)
+    {
+        shapeControlRate = _shapeControlRate;
+        shapeControlRateVal = *shapeControlRate;
+    }
+    flnum getEnvPitch() const override
+    {
+        return DspUtil::valMinusOneToOne (envPitchVal);
+    }
+    void setEnvPitchPtr (const std::atomic<flnum>* _envPitch)
+    {
+        envPitch = _envPitch;
+        envPitchVal = *envPitch;
+    }
+    flnum getEnvShape() const override
+    {
+        return DspUtil::valMinusOneToOne (envShapeVal);
+    }
+    void setEnvShapePtr (const std::atomic<flnum>* _envShape)
+    {
+        envShape = _envShape;
+        envShapeVal = *envShape;
+    }
+    void parameterChanged()
+    {
+        controlIntervalVal = *controlInterval;
+        pitchControlRateVal = *pitchControlRate;
+        filterControlRateVal = *filterControlRate;
+        shapeControlRateVal = *shapeControlRate;
+        envPitchVal = *envPitch;
+        envShapeVal = *envShape;
+    }
+
+private:
+    const std::atomic<flnum>* controlInterval {};
+    const std::atomic<flnum>* pitchControlRate {};
+    const std::atomic<flnum>* filterControlRate {};
+    const std::atomic<flnum>* shapeControlRate {};
+    // Amount of modulation by the envelope
+    const std::atomic<flnum>* envPitch {};
+    const std::atomic<flnum>* envShape {};
+
+    flnum controlIntervalVal = 0.5;
+    flnum pitchControlRateVal = 0.0;
+    flnum filterControlRateVal = 0.0;
+    flnum shapeControlRateVal = 0.0;
+    flnum envPitchVal = 0.5;
+    flnum envShapeVal = 0.5;
+
+    static ModRate toModRate (flnum val)
+    {
+        return val > 0.5 ? ModRate::control : ModRate::audio;
+    }
+};
+} // namespace onsen
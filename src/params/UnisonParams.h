@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+   Unison Parameters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../dsp/DspCommon.h"
+#include <atomic>
+
+namespace onsen
+{
+//==============================================================================
+class IUnisonParams
+{
+public:
+    virtual int getNumVoices() const = 0;
+    virtual flnum getDetune() const = 0;
+    virtual flnum getSpread() const = 0;
+};
+
+//==============================================================================
+class UnisonParams : public IUnisonParams
+{
+public:
+    static constexpr int maxNumVoices = 8;
+
+    //==============================================================================
+    // 1 means unison is off
+    int getNumVoices() const override
+    {
+        return DspUtil::mapFlnumToInt (numVoicesVal, 0.0, 1.0, 1, maxNumVoices);
+    }
+    void setNumVoicesPtr (const std::atomic<flnum>* _numVoices)
+    {
+        numVoices = _numVoices;
+        numVoicesVal = *numVoices;
+    }
+    // In [0, 1]
+    flnum getDetune() const override
+    {
+        return detuneVal;
+    }
+    void setDetunePtr (const std::atomic<flnum>* _detune)
+    {
+        detune = _detune;
+        detuneVal = *detune;
+    }
+    // In [0, 1]. 0 is mono.
+    flnum getSpread() const override
+    {
+        return spreadVal;
+    }
+    void setSpreadPtr (const std::atomic<flnum>* _spread)
+    {
+        spread = _spread;
+        spreadVal = *spread;
+    }
+    void parameterChanged()
+    {
+        numVoicesVal = *numVoices;
+        detuneVal = *detune;
+        spreadVal = *spread;
+    }
+
+private:
+    const std::atomic<flnum>* numVoices {};
+    const std::atomic<flnum>* detune {};
+    const std::atomic<flnum>* spread {};
+
+    flnum numVoicesVal = 0.0;
+    flnum detuneVal = 0.0;
+    flnum spreadVal = 0.0;
+};
+} // namespace onsen
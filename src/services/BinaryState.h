@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+   Binary plugin state
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace onsen
+{
+//==============================================================================
+// Compact format of the processor state which getStateInformation() writes.
+// All the numbers are little endian.
+//
+//   uint32  magic ("O251")
+//   uint16  version
+//   uint16  number of parameters
+//   { uint32 hash of parameter ID, float32 normalized value } * number of parameters
+//   uint16  byte length of the preset path
+//   char    UTF-8 preset path (not terminated)
+//
+// Parameters are identified by hashes so that the state doesn't depend on the
+// order of the parameters. Unknown hashes are skipped on reading.
+namespace BinaryState
+{
+    constexpr uint32_t magic = 0x3135324f; // "O251" in little endian
+    constexpr uint16_t version = 1;
+    constexpr size_t headerSize = 8;
+
+    struct State
+    {
+        std::vector<std::pair<uint32_t, float>> params;
+        std::string presetPath;
+    };
+
+    // 32-bit FNV-1a
+    constexpr uint32_t hashParameterId (const char* id)
+    {
+        uint32_t hash = 2166136261u;
+        for (; *id != '\0'; ++id)
+        {
+            hash ^= static_cast<uint8_t> (*id);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    namespace detail
+    {
+        inline void writeUint (std::vector<uint8_t>& dest, uint32_t val, int numBytes)
+        {
+            for (int i = 0; i < numBytes; ++i)
+            {
+                dest.push_back (static_cast<uint8_t> (val >> (8 * i)));
+            }
+        }
+
+        inline uint32_t readUint (const uint8_t* src, int numBytes)
+        {
+            uint32_t val = 0;
+            for (int i = 0; i < numBytes; ++i)
+            {
+                val |= static_cast<uint32_t> (src[i]) << (8 * i);
+            }
+            return val;
+        }
+    } // namespace detail
+
+    inline void write (const State& state, std::vector<uint8_t>& dest)
+    {
+        dest.clear();
+        dest.reserve (headerSize + state.params.size() * 8 + 2 + state.presetPath.size());
+
+        detail::writeUint (dest, magic, 4);
+        detail::writeUint (dest, version, 2);
+        detail::writeUint (dest, static_cast<uint16_t> (state.params.size()), 2);
+        for (const auto& [hash, value] : state.params)
+        {
+            uint32_t bits;
+            std::memcpy (&bits, &value, sizeof (bits));
+            detail::writeUint (dest, hash, 4);
+            detail::writeUint (dest, bits, 4);
+        }
+        detail::writeUint (dest, static_cast<uint16_t> (state.presetPath.size()), 2);
+        dest.insert (dest.end(), state.presetPath.begin(), state.presetPath.end());
+    }
+
+    // True if `data` starts with the magic number. Otherwise it's an older XML state.
+    inline bool isBinaryState (const void* data, size_t size)
+    {
+        return size >= 4 && detail::readUint (static_cast<const uint8_t*> (data), 4) == magic;
+    }
+
+    // Returns false if `data` is broken or written by a newer version.
+    inline bool read (const void* data, size_t size, State& state)
+    {
+        const auto* src = static_cast<const uint8_t*> (data);
+        if (size < headerSize || ! isBinaryState (data, size))
+        {
+            return false;
+        }
+        if (detail::readUint (src + 4, 2) > version)
+        {
+            return false;
+        }
+
+        const size_t numParams = detail::readUint (src + 6, 2);
+        size_t pos = headerSize;
+        if (size < pos + numParams * 8 + 2)
+        {
+            return false;
+        }
+        state.params.resize (numParams);
+        for (auto& [hash, value] : state.params)
+        {
+            hash = detail::readUint (src + pos, 4);
+            const uint32_t bits = detail::readUint (src + pos + 4, 4);
+            std::memcpy (&value, &bits, sizeof (value));
+            pos += 8;
+        }
+
+        const size_t pathLength = detail::readUint (src + pos, 2);
+        pos += 2;
+        if (size < pos + pathLength)
+        {
+            return false;
+        }
+        state.presetPath.assign (reinterpret_cast<const char*> (src + pos), pathLength);
+        return true;
+    }
+} // namespace BinaryState
+} // namespace onsen
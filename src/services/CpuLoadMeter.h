@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+   CPU load meter
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../dsp/DspCommon.h"
+#include "SpscRingBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace onsen
+{
+//==============================================================================
+// One record per audio callback
+struct CpuLoadRecord
+{
+    double timeSec = 0.0; // When the callback started, from the creation of the meter
+    double durationSec = 0.0;
+    double load = 0.0; // durationSec / the real-time budget of the block (1.0 = 100%)
+    int numSamples = 0;
+    int numActiveVoices = 0;
+    bool xrunRisk = false;
+};
+
+//==============================================================================
+// The audio thread measures each callback with start() and stop(), and the
+// records are read with readRecords() on another thread.
+// It costs two clock reads and a ring buffer push per callback.
+class CpuLoadMeter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Callbacks using more than this ratio of the budget can drop out
+    // when the host or the system adds its own latency.
+    static constexpr double xrunRiskLoad = 0.8;
+    // ~10 sec at 48 kHz with 512 samples per block
+    static constexpr size_t capacity = 1024;
+
+    CpuLoadMeter()
+        : origin (Clock::now()),
+          sampleRate (DEFAULT_SAMPLE_RATE),
+          numDroppedRecords (0)
+    {
+    }
+
+    void prepareToPlay (double _sampleRate)
+    {
+        sampleRate.store (_sampleRate);
+    }
+
+    //==============================================================================
+    // Audio thread
+    Clock::time_point start() const noexcept
+    {
+        return Clock::now();
+    }
+
+    void stop (Clock::time_point startTime, int numSamples, int numActiveVoices) noexcept
+    {
+        const auto endTime = Clock::now();
+        CpuLoadRecord record;
+        record.timeSec = std::chrono::duration<double> (startTime - origin).count();
+        record.durationSec = std::chrono::duration<double> (endTime - startTime).count();
+        record.numSamples = numSamples;
+        record.numActiveVoices = numActiveVoices;
+        const double budgetSec = numSamples / sampleRate.load (std::memory_order_relaxed);
+        record.load = budgetSec > 0.0 ? record.durationSec / budgetSec : 0.0;
+        record.xrunRisk = record.load > xrunRiskLoad;
+
+        if (! records.push (record))
+        {
+            numDroppedRecords.fetch_add (1, std::memory_order_relaxed);
+        }
+    }
+
+    //==============================================================================
+    // Reader thread
+    // `callback` is called with each `const CpuLoadRecord&` in order.
+    // Returns the number of records read.
+    template <typename Callback>
+    int readRecords (Callback&& callback)
+    {
+        int numRead = 0;
+        CpuLoadRecord record;
+        while (records.pop (record))
+        {
+            callback (record);
+            ++numRead;
+        }
+        return numRead;
+    }
+
+    // The records lost because nobody read them in time
+    uint64_t getNumDroppedRecords() const noexcept
+    {
+        return numDroppedRecords.load (std::memory_order_relaxed);
+    }
+
+private:
+    const Clock::time_point origin;
+    std::atomic<double> sampleRate;
+    std::atomic<uint64_t> numDroppedRecords;
+    SpscRingBuffer<CpuLoadRecord, capacity> records;
+};
+} // namespace onsen
@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+   CPU load monitor
+
+  ==============================================================================
+*/
+
+#include "CpuLoadMonitor.h"
+#include <algorithm>
+#include <atomic>
+
+#if JUCE_WINDOWS
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace onsen
+{
+namespace
+{
+int getProcessId()
+{
+#if JUCE_WINDOWS
+    return _getpid();
+#else
+    return static_cast<int> (getpid());
+#endif
+}
+} // namespace
+
+//==============================================================================
+CpuLoadMonitor::CpuLoadMonitor (CpuLoadMeter* const _meter, const juce::File& csvFile)
+    : meter (_meter),
+      csv(),
+      stats(),
+      numUpdates (0),
+      numViewers (0),
+      numIgnoredDroppedRecords (0)
+{
+    if (csvFile != juce::File())
+    {
+        csvFile.deleteFile();
+        csv = std::make_unique<juce::FileOutputStream> (csvFile);
+        if (csv->openedOk())
+        {
+            *csv << "time_sec,duration_ms,load_percent,num_samples,active_voices,xrun_risk\n";
+        }
+        else
+        {
+            csv.reset();
+        }
+    }
+    updateTimer();
+}
+
+CpuLoadMonitor::~CpuLoadMonitor()
+{
+    stopTimer();
+    if (csv)
+    {
+        csv->flush();
+    }
+}
+
+juce::File CpuLoadMonitor::getCsvFileFromEnvironment()
+{
+    auto path = juce::SystemStats::getEnvironmentVariable ("OS251_CPU_LOAD_CSV", {});
+    if (path.isEmpty() || ! juce::File::isAbsolutePath (path))
+    {
+        return {};
+    }
+    static std::atomic<int> nextInstanceIndex { 0 };
+    const juce::File file (path);
+    return file.getSiblingFile (file.getFileNameWithoutExtension()
+                                + "_" + juce::String (getProcessId())
+                                + "_" + juce::String (nextInstanceIndex++)
+                                + file.getFileExtension());
+}
+
+void CpuLoadMonitor::addViewer()
+{
+    ++numViewers;
+    updateTimer();
+}
+
+void CpuLoadMonitor::removeViewer()
+{
+    jassert (numViewers > 0);
+    --numViewers;
+    updateTimer();
+}
+
+void CpuLoadMonitor::updateTimer()
+{
+    if (numViewers == 0 && ! csv)
+    {
+        stopTimer();
+    }
+    else if (! isTimerRunning())
+    {
+        // The records pushed while the timer was stopped are stale
+        meter->readRecords ([] (const CpuLoadRecord&) {});
+        numIgnoredDroppedRecords = meter->getNumDroppedRecords() - stats.numDroppedRecords;
+        startTimerHz (updateRateHz);
+    }
+}
+
+//==============================================================================
+void CpuLoadMonitor::timerCallback()
+{
+    double sumOfLoad = 0.0;
+    double peakLoad = 0.0;
+    int numActiveVoices = 0;
+    int numXrunRisks = 0;
+    const int numRecords = meter->readRecords ([&] (const CpuLoadRecord& record) {
+        sumOfLoad += record.load;
+        peakLoad = std::max (peakLoad, record.load);
+        numActiveVoices = record.numActiveVoices;
+        if (record.xrunRisk)
+        {
+            ++numXrunRisks;
+        }
+        if (csv)
+        {
+            writeCsvRecord (record);
+        }
+    });
+
+    const auto numDroppedRecords = meter->getNumDroppedRecords() - numIgnoredDroppedRecords;
+    if (numRecords == 0 && numDroppedRecords == stats.numDroppedRecords)
+    {
+        // The host doesn't call processBlock(). Keep the last stats.
+        return;
+    }
+
+    if (numRecords > 0)
+    {
+        stats.averageLoad = sumOfLoad / numRecords;
+        stats.peakLoad = peakLoad;
+        stats.numActiveVoices = numActiveVoices;
+        stats.numXrunRisks += numXrunRisks;
+    }
+    stats.numDroppedRecords = numDroppedRecords;
+    ++numUpdates;
+
+    if (csv)
+    {
+        csv->flush();
+    }
+}
+
+void CpuLoadMonitor::writeCsvRecord (const CpuLoadRecord& record)
+{
+    *csv << juce::String (record.timeSec, 6) << ","
+         << juce::String (record.durationSec * 1000.0, 4) << ","
+         << juce::String (record.load * 100.0, 2) << ","
+         << record.numSamples << ","
+         << record.numActiveVoices << ","
+         << (record.xrunRisk ? 1 : 0) << "\n";
+}
+} // namespace onsen
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+   CPU load monitor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "CpuLoadMeter.h"
+#include <JuceHeader.h>
+#include <memory>
+
+namespace onsen
+{
+//==============================================================================
+// It reads the records of CpuLoadMeter on the message thread and summarizes
+// them for the UI. If `csvFile` is given, every record is also appended to it.
+// It reads only while a viewer shows the stats or the CSV file is written.
+class CpuLoadMonitor : private juce::Timer
+{
+public:
+    // Summary of the records read in the last update
+    struct Stats
+    {
+        double averageLoad = 0.0;
+        double peakLoad = 0.0;
+        int numActiveVoices = 0;
+        // Totals while the monitor has been reading
+        int numXrunRisks = 0;
+        uint64_t numDroppedRecords = 0;
+    };
+
+    CpuLoadMonitor() = delete;
+    CpuLoadMonitor (CpuLoadMeter* const _meter, const juce::File& csvFile = {});
+    ~CpuLoadMonitor() override;
+
+    const Stats& getStats() const
+    {
+        return stats;
+    }
+
+    // Incremented every time `stats` changes
+    int getNumUpdates() const
+    {
+        return numUpdates;
+    }
+
+    // Call them on the message thread when a view starts and stops showing the stats
+    void addViewer();
+    void removeViewer();
+
+    // The path of the CSV file is taken from this environment variable.
+    // The process ID and the index of the instance are appended to the name,
+    // e.g. load_1234_0.csv for load.csv, so that the instances don't write
+    // to the same file.
+    static juce::File getCsvFileFromEnvironment();
+
+private:
+    static constexpr int updateRateHz = 10;
+
+    CpuLoadMeter* const meter;
+    std::unique_ptr<juce::FileOutputStream> csv;
+    Stats stats;
+    int numUpdates;
+    int numViewers;
+    // Records dropped while nothing was reading aren't counted
+    uint64_t numIgnoredDroppedRecords;
+
+    void updateTimer();
+    void timerCallback() override;
+    void writeCsvRecord (const CpuLoadRecord& record);
+};
+} // namespace onsen
@@ -21,7 +21,8 @@ struct BinaryPreset
     const int size;
 };
 //==============================================================================
-static std::array<BinaryPreset, 16> factoryPresets = { {
+// Inline so that every translation unit refers to the same table
+inline const std::array<BinaryPreset, 16> factoryPresets = { {
 
     { "Bass/Bass0.oapreset", BinaryData::Bass0_oapreset, BinaryData::Bass0_oapresetSize },
     { "Bass/Bass1.oapreset", BinaryData::Bass1_oapreset, BinaryData::Bass1_oapresetSize },
@@ -0,0 +1,227 @@
+/*
+  ==============================================================================
+
+   Preset Index
+
+  ==============================================================================
+*/
+
+#include "PresetIndex.h"
+#include <unordered_set>
+
+namespace onsen
+{
+//==============================================================================
+
+PresetIndex::PresetIndex (juce::File _presetDir)
+    : presetDir (_presetDir),
+      entries(),
+      isDirty (false)
+{
+}
+
+juce::File PresetIndex::getIndexFile() const
+{
+    return presetDir.getChildFile (".preset_index");
+}
+
+/*
+    Index file format (little endian)
+
+    int32   magic
+    int32   version
+    int32   number of entries
+    Entries
+        string  relative path (null terminated UTF-8)
+        string  name
+        string  category
+        int64   modification time [ms]
+        int64   file size
+        bool    valid
+        int32   byte size of params
+        bytes   params
+    */
+void PresetIndex::load()
+{
+    entries.clear();
+    isDirty = false;
+
+    // Map it instead of reading it through a stream because it's read at startup
+    juce::MemoryMappedFile mappedFile (getIndexFile(), juce::MemoryMappedFile::readOnly);
+    if (mappedFile.getData() == nullptr)
+        return;
+
+    juce::MemoryInputStream is (mappedFile.getData(), mappedFile.getSize(), false);
+    if (is.readInt() != magic || is.readInt() != version)
+        return;
+
+    const int numEntries = is.readInt();
+    for (int i = 0; i < numEntries; ++i)
+    {
+        const auto key = is.readString();
+        Entry entry;
+        entry.name = is.readString();
+        entry.category = is.readString();
+        entry.modificationTime = is.readInt64();
+        entry.fileSize = is.readInt64();
+        entry.isValid = is.readBool();
+        const int paramsSize = is.readInt();
+        if (paramsSize < 0 || paramsSize > is.getNumBytesRemaining())
+        {
+            // Broken
+            entries.clear();
+            return;
+        }
+        is.readIntoMemoryBlock (entry.params, paramsSize);
+        entries[key] = std::move (entry);
+    }
+}
+
+void PresetIndex::save()
+{
+    if (! isDirty)
+        return;
+
+    // Write a temporary file and replace the index with it at once,
+    // because other instances of the plugin can read the index at the same time.
+    juce::TemporaryFile tmpFile (getIndexFile());
+    {
+        juce::FileOutputStream os (tmpFile.getFile());
+        if (! os.openedOk())
+            return;
+
+        os.writeInt (magic);
+        os.writeInt (version);
+        os.writeInt (static_cast<int> (entries.size()));
+        for (const auto& [key, entry] : entries)
+        {
+            os.writeString (key);
+            os.writeString (entry.name);
+            os.writeString (entry.category);
+            os.writeInt64 (entry.modificationTime);
+            os.writeInt64 (entry.fileSize);
+            os.writeBool (entry.isValid);
+            os.writeInt (static_cast<int> (entry.params.getSize()));
+            os.write (entry.params.getData(), entry.params.getSize());
+        }
+        os.flush();
+    }
+    if (tmpFile.overwriteTargetFileWithTemporary())
+        isDirty = false;
+}
+
+const PresetIndex::Entry* PresetIndex::find (const juce::File& file) const
+{
+    auto it = entries.find (getKey (file));
+    if (it == entries.end())
+        return nullptr;
+
+    Entry stamp;
+    setStamp (file, stamp);
+    if (it->second.modificationTime != stamp.modificationTime || it->second.fileSize != stamp.fileSize)
+        return nullptr;
+
+    return &it->second;
+}
+
+void PresetIndex::add (const juce::File& file, Entry entry)
+{
+    entries[getKey (file)] = std::move (entry);
+    isDirty = true;
+}
+
+void PresetIndex::remove (const juce::File& file)
+{
+    if (entries.erase (getKey (file)) > 0)
+        isDirty = true;
+}
+
+void PresetIndex::retainOnly (const juce::Array<juce::File>& files)
+{
+    std::unordered_set<juce::String> keys;
+    for (auto& file : files)
+        keys.insert (getKey (file));
+
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if (keys.count (it->first) == 0)
+        {
+            it = entries.erase (it);
+            isDirty = true;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+int PresetIndex::size() const
+{
+    return static_cast<int> (entries.size());
+}
+
+//==============================================================================
+
+void PresetIndex::setStamp (const juce::File& file, Entry& entry)
+{
+    entry.modificationTime = file.getLastModificationTime().toMilliseconds();
+    entry.fileSize = file.getSize();
+}
+
+/*
+    Params format (little endian)
+
+    int32   number of parameters
+    Parameters
+        string   parameter ID (null terminated UTF-8)
+        float32  value
+    */
+juce::MemoryBlock PresetIndex::encodeParams (const juce::XmlElement& stateXml)
+{
+    if (stateXml.getNumAttributes() != 0)
+        return {};
+
+    juce::MemoryOutputStream os;
+    os.writeInt (stateXml.getNumChildElements());
+    for (int i = 0; i < stateXml.getNumChildElements(); ++i)
+    {
+        const auto* paramXml = stateXml.getChildElement (i);
+        // Only <PARAM id="..." value="..."/> can be restored from params
+        if (! paramXml->hasTagName ("PARAM")
+            || paramXml->getNumAttributes() != 2
+            || ! paramXml->hasAttribute ("id")
+            || ! paramXml->hasAttribute ("value")
+            || paramXml->getNumChildElements() != 0)
+        {
+            return {};
+        }
+        os.writeString (paramXml->getStringAttribute ("id"));
+        os.writeFloat (static_cast<float> (paramXml->getDoubleAttribute ("value")));
+    }
+    return os.getMemoryBlock();
+}
+
+juce::ValueTree PresetIndex::decodeParams (const juce::MemoryBlock& params, const juce::Identifier& stateType)
+{
+    juce::ValueTree state (stateType);
+    juce::MemoryInputStream is (params, false);
+    const int numParams = is.readInt();
+    for (int i = 0; i < numParams; ++i)
+    {
+        juce::ValueTree param ("PARAM");
+        // The same order as attributes in XML
+        param.setProperty ("id", is.readString(), nullptr);
+        param.setProperty ("value", static_cast<double> (is.readFloat()), nullptr);
+        state.appendChild (param, nullptr);
+    }
+    return state;
+}
+
+//==============================================================================
+
+juce::String PresetIndex::getKey (const juce::File& file) const
+{
+    return file.getRelativePathFrom (presetDir);
+}
+} // namespace onsen
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+   Preset Index
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <unordered_map>
+
+namespace onsen
+{
+//==============================================================================
+/*
+PresetIndex
+
+Cache of preset metadata persisted in the preset folder. An entry is used only
+while the modification time and the size of the preset file are the same as
+when it was indexed, so that presets don't need to be parsed on every scan.
+*/
+class PresetIndex
+{
+public:
+    struct Entry
+    {
+        juce::String name;
+        juce::String category; // Sub folder in Factory or User. Empty for the default preset.
+        juce::int64 modificationTime = 0; // [ms]
+        juce::int64 fileSize = 0;
+        bool isValid = false;
+        // Values of the parameters in the preset. See encodeParams().
+        // Empty if the state can't be restored only from them.
+        juce::MemoryBlock params;
+    };
+
+    PresetIndex (juce::File _presetDir);
+
+    juce::File getIndexFile() const;
+
+    /*
+    Reads the index file. Entries are cleared if it doesn't exist or is broken.
+    */
+    void load();
+
+    /*
+    Writes the index file if entries are changed after load() or save().
+    */
+    void save();
+
+    /*
+    Returns nullptr if `file` isn't indexed or is changed after indexed
+    */
+    const Entry* find (const juce::File& file) const;
+    void add (const juce::File& file, Entry entry);
+    void remove (const juce::File& file);
+
+    /*
+    Removes entries of files which aren't in `files`
+    */
+    void retainOnly (const juce::Array<juce::File>& files);
+
+    int size() const;
+
+    //==============================================================================
+    static void setStamp (const juce::File& file, Entry& entry);
+    // <OS-251><PARAM id="..." value="..."/>...</OS-251> to compact binary
+    static juce::MemoryBlock encodeParams (const juce::XmlElement& stateXml);
+    static juce::ValueTree decodeParams (const juce::MemoryBlock& params, const juce::Identifier& stateType);
+
+private:
+    static constexpr int magic = 0x4950324f; // "O2PI" in little endian
+    static constexpr int version = 1;
+
+    const juce::File presetDir;
+    // By the path relative to presetDir
+    std::unordered_map<juce::String, Entry> entries;
+    bool isDirty;
+
+    juce::String getKey (const juce::File& file) const;
+};
+} // namespace onsen
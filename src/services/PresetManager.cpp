@@ -7,6 +7,8 @@
 */
 
 #include "PresetManager.h"
+#include "SharedResources.h"
+#include "Trace.h"
 
 namespace onsen
 {
@@ -14,24 +16,42 @@ namespace onsen
 
 PresetManager::PresetManager (IAudioProcessorState* _processorState, juce::File _presetDir)
     : processorState (_processorState),
+      processorName (_processorState->getProcessorName()),
       presetDir (_presetDir),
-      factoryPresetFiles(),
-      userPresetFiles(),
-      presetFiles(),
-      currentPresetFile (getDefaultPresetFile())
+      presetList (std::make_shared<PresetList>()),
+      currentPresetFile(),
+      embeddedDefaultPresetXml(),
+      presetIndex (_presetDir),
+      isPresetIndexLoaded (false),
+      requestedPresetFile(),
+      lastLoadRequestId (0),
+      isLoadingPresetAsync (false),
+      loadingThreadPool(),
+      sharedPresetWatchers()
 {
-    updateCurrentPresetBasedOnProcessorState();
+    // Nothing is read from the disk here. See loadEmbeddedDefaultPreset().
+}
+
+PresetManager::~PresetManager()
+{
+    sharedPresetWatchers->unsubscribe (this);
 }
 //==============================================================================
 void PresetManager::scanPresets()
 {
-    restorePresetFoldersAndPresetsIfNecessary();
-    scanPresets (getFactoryPresetDir(), factoryPresetFiles);
-    scanPresets (getUserPresetDir(), userPresetFiles);
-    presetFiles.clear();
-    presetFiles.add (getDefaultPresetFile());
-    presetFiles.addArray (factoryPresetFiles);
-    presetFiles.addArray (userPresetFiles);
+    const juce::ScopedLock sl (scanLock);
+    publishPresetList (buildPresetList());
+}
+
+void PresetManager::scanPresetsAsync()
+{
+    sharedPresetWatchers->subscribe (this);
+}
+
+PresetManager::PresetListPtr PresetManager::getPresetList()
+{
+    const juce::ScopedLock sl (presetListLock);
+    return presetList;
 }
 
 juce::File PresetManager::getDefaultPresetFile()
@@ -51,17 +71,17 @@ juce::File PresetManager::getUserPresetDir()
 
 juce::Array<juce::File> PresetManager::getPresets()
 {
-    return presetFiles;
+    return getPresetList()->presetFiles;
 }
 
 juce::Array<juce::File> PresetManager::getFactoryPresets()
 {
-    return factoryPresetFiles;
+    return getPresetList()->factoryPresetFiles;
 }
 
 juce::Array<juce::File> PresetManager::getUserPresets()
 {
-    return userPresetFiles;
+    return getPresetList()->userPresetFiles;
 }
 
 /*
@@ -109,6 +129,11 @@ void PresetManager::savePreset (juce::File file)
     stateContainerXml->addChildElement (stateXml.release());
     presetXml->addChildElement (stateContainerXml.release());
     presetXml->writeTo (file);
+    // The file can be rewritten without changing its time stamp and size
+    {
+        const juce::ScopedLock sl (presetIndexLock);
+        getPresetIndex().remove (file);
+    }
 
     currentPresetFile = file;
 }
@@ -118,18 +143,70 @@ void PresetManager::savePreset (juce::File file)
     */
 void PresetManager::loadPreset (juce::File file)
 {
+    OS251_TRACE_SCOPE ("PresetManager::loadPreset");
+    // Cancel the async request if any
+    ++lastLoadRequestId;
+    isLoadingPresetAsync = false;
+
+    if (loadIndexedPreset (file))
+        return;
+
     juce::XmlDocument xmlDocument (file);
     std::unique_ptr<juce::XmlElement> presetXml (xmlDocument.getDocumentElement());
+    loadPresetXml (file, presetXml.get());
+}
 
-    if (validatePresetXml (presetXml.get()))
+void PresetManager::loadEmbeddedDefaultPreset()
+{
+    // Parsed only once while any instance of the plugin is alive
+    if (embeddedDefaultPresetXml == nullptr)
     {
-        loadPresetState (presetXml.get());
-        auto presetRelativePath = file.getRelativePathFrom (getPresetDir());
-        processorState->setPreset (presetRelativePath);
-        currentPresetFile = file;
+        embeddedDefaultPresetXml = SharedResources::get<juce::XmlElement> ("Default.oapreset", []() {
+            return juce::parseXML (juce::String::createStringFromData (BinaryData::Default_oapreset, BinaryData::Default_oapresetSize));
+        });
     }
-    else
-        loadDefaultFileSafely(); // TODO: change behavior?
+
+    // Cancel the async request if any
+    ++lastLoadRequestId;
+    isLoadingPresetAsync = false;
+
+    jassert (validatePresetXml (embeddedDefaultPresetXml.get()));
+    loadPresetState (embeddedDefaultPresetXml.get());
+    auto file = getDefaultPresetFile();
+    auto presetRelativePath = file.getRelativePathFrom (getPresetDir());
+    processorState->setPreset (presetRelativePath);
+    currentPresetFile = file;
+}
+
+void PresetManager::loadPresetAsync (juce::File file)
+{
+    const int requestId = ++lastLoadRequestId;
+    requestedPresetFile = file;
+    isLoadingPresetAsync = false;
+
+    // Indexed presets are loaded without parsing
+    if (loadIndexedPreset (file))
+    {
+        requireToUpdatePresetNameOnUI();
+        return;
+    }
+
+    isLoadingPresetAsync = true;
+    juce::WeakReference<PresetManager> weakThis (this);
+    loadingThreadPool->addJob ([weakThis, file, requestId]() {
+        OS251_TRACE_SCOPE ("PresetManager::parsePreset");
+        juce::XmlDocument xmlDocument (file);
+        std::shared_ptr<juce::XmlElement> presetXml (xmlDocument.getDocumentElement().release());
+
+        juce::MessageManager::callAsync ([weakThis, file, presetXml, requestId]() {
+            // Ignore it if a newer preset is requested
+            if (weakThis == nullptr || weakThis->lastLoadRequestId != requestId)
+                return;
+            weakThis->isLoadingPresetAsync = false;
+            weakThis->loadPresetXml (file, presetXml.get());
+            weakThis->requireToUpdatePresetNameOnUI();
+        });
+    });
 }
 
 juce::File PresetManager::getCurrentPresetFile()
@@ -145,31 +222,56 @@ juce::String PresetManager::getPresetName (juce::File file)
 
 void PresetManager::loadPrev()
 {
-    // TODO: If it's slow, Use hash table or binary search. Or cache
-    //       currentPresetFile's index (Note that cached index can't be used
-    //       after presetFiles is updated)
-    int idx = presetFiles.indexOf (currentPresetFile);
+    const auto list = getPresetList();
+    int idx = getPresetIdx (*list, currentPresetFile);
     if (idx > 0)
-        loadPreset (presetFiles[idx - 1]);
+        loadPreset (list->presetFiles[idx - 1]);
     else if (idx < 0) // Usually it doesn't happen
         loadPreset (getDefaultPresetFile());
 }
 
 void PresetManager::loadNext()
 {
-    int idx = presetFiles.indexOf (currentPresetFile);
-    if (idx < presetFiles.size() - 1)
-        loadPreset (presetFiles[idx + 1]);
+    const auto list = getPresetList();
+    int idx = getPresetIdx (*list, currentPresetFile);
+    if (idx < list->presetFiles.size() - 1)
+        loadPreset (list->presetFiles[idx + 1]);
     else if (idx < 0) // Usually it doesn't happen
         loadPreset (getDefaultPresetFile());
 }
 
+void PresetManager::loadPrevAsync()
+{
+    const auto list = getPresetList();
+    int idx = getPresetIdx (*list, getPresetFileForNavigation());
+    if (idx > 0)
+        loadPresetAsync (list->presetFiles[idx - 1]);
+    else if (idx < 0) // Usually it doesn't happen
+        loadPresetAsync (getDefaultPresetFile());
+}
+
+void PresetManager::loadNextAsync()
+{
+    const auto list = getPresetList();
+    int idx = getPresetIdx (*list, getPresetFileForNavigation());
+    if (idx < list->presetFiles.size() - 1)
+        loadPresetAsync (list->presetFiles[idx + 1]);
+    else if (idx < 0) // Usually it doesn't happen
+        loadPresetAsync (getDefaultPresetFile());
+}
+
 //==============================================================================
 
 bool PresetManager::validatePresetFile (juce::File file)
 {
     if (file.getFullPathName() == "" || ! file.existsAsFile())
         return false;
+    {
+        const juce::ScopedLock sl (presetIndexLock);
+        if (const auto* entry = getPresetIndex().find (file))
+            return entry->isValid;
+    }
+
     juce::XmlDocument xmlDocument (file);
     std::unique_ptr<juce::XmlElement> presetXml (xmlDocument.getDocumentElement());
 
@@ -191,7 +293,7 @@ bool PresetManager::validatePresetXml (juce::XmlElement const* const presetXml)
         && presetXml->getChildByName ("Version")->getFirstChildElement()->isTextElement()
         && presetXml->getChildByName ("Version")->getFirstChildElement()->getText() == "0"
         && presetXml->getChildByName ("State") != nullptr
-        && presetXml->getChildByName ("State")->getChildByName (processorState->getProcessorName()) != nullptr)
+        && presetXml->getChildByName ("State")->getChildByName (processorName) != nullptr)
         return true;
 
     return false;
@@ -199,10 +301,49 @@ bool PresetManager::validatePresetXml (juce::XmlElement const* const presetXml)
 
 void PresetManager::loadPresetState (juce::XmlElement const* const presetXml)
 {
+    OS251_TRACE_SCOPE ("PresetManager::loadPresetState");
     processorState->replaceState (juce::ValueTree::fromXml (
         *(presetXml->getChildByName ("State")->getChildByName (processorState->getProcessorName()))));
 }
 
+bool PresetManager::loadIndexedPreset (juce::File file)
+{
+    juce::ValueTree state;
+    {
+        const juce::ScopedLock sl (presetIndexLock);
+        const auto* entry = getPresetIndex().find (file);
+        if (entry == nullptr || ! entry->isValid || entry->params.getSize() == 0)
+            return false;
+        state = PresetIndex::decodeParams (entry->params, processorName);
+    }
+
+    processorState->replaceState (state);
+    auto presetRelativePath = file.getRelativePathFrom (getPresetDir());
+    processorState->setPreset (presetRelativePath);
+    currentPresetFile = file;
+    return true;
+}
+
+void PresetManager::loadPresetXml (juce::File file, juce::XmlElement const* const presetXml)
+{
+    if (validatePresetXml (presetXml))
+    {
+        loadPresetState (presetXml);
+        auto presetRelativePath = file.getRelativePathFrom (getPresetDir());
+        processorState->setPreset (presetRelativePath);
+        currentPresetFile = file;
+    }
+    else
+        loadDefaultFileSafely(); // TODO: change behavior?
+}
+
+juce::File PresetManager::getPresetFileForNavigation()
+{
+    // Move from the requested preset so that clicking prev/next repeatedly
+    // doesn't request the same preset while the previous one is loading.
+    return isLoadingPresetAsync ? requestedPresetFile : currentPresetFile;
+}
+
 void PresetManager::requireToUpdatePresetNameOnUI()
 {
     if (onNeedToUpdateUI != nullptr)
@@ -243,13 +384,201 @@ juce::File PresetManager::getPresetDir()
     return presetDir;
 }
 
-juce::Array<juce::File> PresetManager::scanPresets (juce::File dir, juce::Array<juce::File>& presetFiles)
+juce::Array<juce::File> PresetManager::scanPresets (juce::File dir)
 {
     dir.createDirectory(); // OK if it exists.
     auto files = dir.findChildFiles (juce::File::TypesOfFileToFind::findFiles, true, "*.oapreset");
     files.sort();
+    for (auto& file : files)
+        indexPreset (file, dir);
+
+    return files;
+}
+
+// scanLock should be held
+PresetManager::PresetListPtr PresetManager::buildPresetList()
+{
+    restorePresetFoldersAndPresetsIfNecessary();
+    auto newPresetList = makePresetList (scanPresets (getFactoryPresetDir()), scanPresets (getUserPresetDir()));
+
+    indexPreset (getDefaultPresetFile(), getPresetDir());
+    const juce::ScopedLock sl (presetIndexLock);
+    getPresetIndex().retainOnly (newPresetList->presetFiles);
+    getPresetIndex().save();
+    return newPresetList;
+}
+
+// scanLock should be held
+PresetManager::PresetListPtr PresetManager::updatePresetList (const juce::Array<juce::File>& changedFiles)
+{
+    const auto currentPresetList = getPresetList();
+    auto factoryPresetFiles = currentPresetList->factoryPresetFiles;
+    auto userPresetFiles = currentPresetList->userPresetFiles;
+
+    for (const auto& file : changedFiles)
+    {
+        if (file == getDefaultPresetFile())
+        {
+            if (! file.existsAsFile())
+                return buildPresetList(); // Restore it
+            indexPreset (file, getPresetDir());
+            continue;
+        }
+        if (! file.hasFileExtension (".oapreset"))
+            continue; // e.g. the preset index
+
+        const bool isFactoryPreset = file.isAChildOf (getFactoryPresetDir());
+        if (! isFactoryPreset && ! file.isAChildOf (getUserPresetDir()))
+            continue;
+
+        auto& files = isFactoryPreset ? factoryPresetFiles : userPresetFiles;
+        files.removeFirstMatchingValue (file);
+        if (file.existsAsFile())
+        {
+            files.add (file);
+            indexPreset (file, isFactoryPreset ? getFactoryPresetDir() : getUserPresetDir());
+        }
+    }
 
-    return presetFiles = files;
+    factoryPresetFiles.sort();
+    userPresetFiles.sort();
+    auto newPresetList = makePresetList (factoryPresetFiles, userPresetFiles);
+
+    const juce::ScopedLock sl (presetIndexLock);
+    getPresetIndex().retainOnly (newPresetList->presetFiles);
+    getPresetIndex().save();
+    return newPresetList;
+}
+
+PresetManager::PresetListPtr PresetManager::makePresetList (juce::Array<juce::File> factoryPresetFiles, juce::Array<juce::File> userPresetFiles)
+{
+    auto list = std::make_shared<PresetList>();
+    list->factoryPresetFiles = factoryPresetFiles;
+    list->userPresetFiles = userPresetFiles;
+    list->presetFiles.add (getDefaultPresetFile());
+    list->presetFiles.addArray (factoryPresetFiles);
+    list->presetFiles.addArray (userPresetFiles);
+    for (int i = 0; i < list->presetFiles.size(); ++i)
+        list->presetIdxByPath[list->presetFiles[i].getFullPathName()] = i;
+    return list;
+}
+
+void PresetManager::publishPresetList (PresetListPtr newPresetList)
+{
+    {
+        const juce::ScopedLock sl (presetListLock);
+        if (newPresetList->presetFiles == presetList->presetFiles)
+            return;
+        presetList = newPresetList;
+    }
+    // Notify it on the message thread
+    triggerAsyncUpdate();
+}
+
+void PresetManager::handleAsyncUpdate()
+{
+    if (onPresetListChanged != nullptr)
+        onPresetListChanged();
+}
+
+//==============================================================================
+void PresetManager::SharedPresetWatchers::subscribe (PresetManager* manager)
+{
+    const auto path = manager->presetDir.getFullPathName();
+    const juce::ScopedLock sl (lock);
+    auto& folder = folders[path];
+    folder.managers.addIfNotAlreadyThere (manager);
+    if (folder.watcher == nullptr)
+    {
+        folder.watcher = std::make_unique<PresetWatcher> (manager->presetDir);
+        folder.watcher->onFullScan = [this, path]() {
+            scan (path, nullptr);
+        };
+        folder.watcher->onFilesChanged = [this, path] (const juce::Array<juce::File>& changedFiles) {
+            scan (path, &changedFiles);
+        };
+    }
+    folder.watcher->requestFullScan();
+}
+
+void PresetManager::SharedPresetWatchers::unsubscribe (PresetManager* manager)
+{
+    std::unique_ptr<PresetWatcher> unusedWatcher;
+    {
+        const juce::ScopedLock sl (lock);
+        auto it = folders.find (manager->presetDir.getFullPathName());
+        if (it == folders.end())
+            return;
+        it->second.managers.removeFirstMatchingValue (manager);
+        if (it->second.managers.isEmpty())
+        {
+            unusedWatcher = std::move (it->second.watcher);
+            folders.erase (it);
+        }
+    }
+    // Stopped without the lock because its thread may be waiting for it
+    unusedWatcher.reset();
+}
+
+void PresetManager::SharedPresetWatchers::scan (const juce::String& path, const juce::Array<juce::File>* changedFiles)
+{
+    const juce::ScopedLock sl (lock);
+    auto it = folders.find (path);
+    if (it == folders.end())
+        return;
+
+    auto* scanner = it->second.managers.getFirst();
+    PresetListPtr newPresetList;
+    {
+        const juce::ScopedLock scanSl (scanner->scanLock);
+        newPresetList = changedFiles == nullptr ? scanner->buildPresetList()
+                                                : scanner->updatePresetList (*changedFiles);
+    }
+    for (auto* manager : it->second.managers)
+        manager->publishPresetList (newPresetList);
+}
+
+void PresetManager::indexPreset (juce::File file, juce::File categoryRootDir)
+{
+    {
+        const juce::ScopedLock sl (presetIndexLock);
+        if (getPresetIndex().find (file) != nullptr)
+            return;
+    }
+
+    PresetIndex::Entry entry;
+    entry.name = getPresetName (file);
+    if (file.getParentDirectory() != categoryRootDir)
+        entry.category = file.getParentDirectory().getRelativePathFrom (categoryRootDir);
+    PresetIndex::setStamp (file, entry);
+
+    juce::XmlDocument xmlDocument (file);
+    std::unique_ptr<juce::XmlElement> presetXml (xmlDocument.getDocumentElement());
+    entry.isValid = validatePresetXml (presetXml.get());
+    if (entry.isValid)
+        entry.params = PresetIndex::encodeParams (
+            *(presetXml->getChildByName ("State")->getChildByName (processorName)));
+
+    const juce::ScopedLock sl (presetIndexLock);
+    getPresetIndex().add (file, std::move (entry));
+}
+
+// presetIndexLock should be held
+PresetIndex& PresetManager::getPresetIndex()
+{
+    // Loaded on the first use to keep the construction free from file access
+    if (! isPresetIndexLoaded)
+    {
+        presetIndex.load();
+        isPresetIndexLoaded = true;
+    }
+    return presetIndex;
+}
+
+int PresetManager::getPresetIdx (const PresetList& list, juce::File file)
+{
+    auto it = list.presetIdxByPath.find (file.getFullPathName());
+    return it != list.presetIdxByPath.end() ? it->second : -1;
 }
 
 void PresetManager::restorePresetFoldersAndPresetsIfNecessary()
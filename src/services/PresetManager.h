@@ -10,7 +10,11 @@
 
 #include "../IAudioProcessorState.h"
 #include "FactoryPresets.h"
+#include "PresetIndex.h"
+#include "PresetWatcher.h"
 #include <JuceHeader.h>
+#include <memory>
+#include <unordered_map>
 
 namespace onsen
 {
@@ -19,13 +23,39 @@ namespace onsen
 /*
 PresetManager
 
-Note: scanPresets() need to be called before save/load presets
+Note: scanPresets() or scanPresetsAsync() need to be called before save/load presets
 */
-class PresetManager
+class PresetManager : private juce::AsyncUpdater
 {
 public:
+    /*
+    Immutable snapshot of the preset folder. A new one is published when
+    the presets are changed, so it can be read without locking.
+    */
+    struct PresetList
+    {
+        juce::Array<juce::File> factoryPresetFiles;
+        juce::Array<juce::File> userPresetFiles;
+        // Default, factory and user presets
+        juce::Array<juce::File> presetFiles;
+        // Index in presetFiles by full path
+        std::unordered_map<juce::String, int> presetIdxByPath;
+    };
+    using PresetListPtr = std::shared_ptr<const PresetList>;
+
     PresetManager (IAudioProcessorState* _processorState, juce::File _presetDir);
+    ~PresetManager() override;
     void scanPresets();
+
+    /*
+    Scans presets on a background thread like scanPresets() and keeps
+    watching the preset folder. onPresetListChanged is called on the message
+    thread when a new list is published.
+    The managers of the same folder share the watcher, and only one of them
+    scans and writes the preset index for all.
+    */
+    void scanPresetsAsync();
+    PresetListPtr getPresetList();
     juce::File getDefaultPresetFile();
     juce::File getFactoryPresetDir();
     juce::File getUserPresetDir();
@@ -45,34 +75,104 @@ public:
     */
     void loadPreset (juce::File file);
 
+    /*
+    Loads the default preset embedded in the plugin without any file access.
+    It's used at construction so that the preset folder is touched only when
+    presets are used.
+    */
+    void loadEmbeddedDefaultPreset();
+
+    /*
+    Loads preset file like loadPreset() but parses it on a background thread.
+    The preset is applied on the message thread, and only the latest request
+    is applied.
+    */
+    void loadPresetAsync (juce::File file);
+
     juce::File getCurrentPresetFile();
     static juce::String getPresetName (juce::File file);
     void loadPrev();
     void loadNext();
+    void loadPrevAsync();
+    void loadNextAsync();
     void requireToUpdatePresetNameOnUI();
 
     //==============================================================================
     std::function<void()> onNeedToUpdateUI;
+    std::function<void()> onPresetListChanged;
 
 private:
     IAudioProcessorState* processorState;
+    // Cached because the processor state can't be read from the watcher thread
+    const juce::String processorName;
     const juce::File presetDir;
-    juce::Array<juce::File> factoryPresetFiles;
-    juce::Array<juce::File> userPresetFiles;
-    juce::Array<juce::File> presetFiles;
+    PresetListPtr presetList;
+    juce::CriticalSection presetListLock;
+    // Serializes scans on the message thread and the watcher thread
+    juce::CriticalSection scanLock;
     juce::File currentPresetFile;
+    std::shared_ptr<const juce::XmlElement> embeddedDefaultPresetXml;
+    // Use getPresetIndex()
+    PresetIndex presetIndex;
+    bool isPresetIndexLoaded;
+    juce::CriticalSection presetIndexLock;
+    juce::File requestedPresetFile;
+    int lastLoadRequestId;
+    bool isLoadingPresetAsync;
+    // One loading thread is shared by all the instances. The jobs touch the
+    // manager only through a weak reference on the message thread.
+    struct LoadingThreadPool : public juce::ThreadPool
+    {
+        LoadingThreadPool() : juce::ThreadPool (1) {}
+    };
+    juce::SharedResourcePointer<LoadingThreadPool> loadingThreadPool;
+    // One watcher for each preset folder, shared by all the instances.
+    // The first manager of a folder scans it, and the list is published to
+    // all of them.
+    struct SharedPresetWatchers
+    {
+        struct Folder
+        {
+            std::unique_ptr<PresetWatcher> watcher;
+            juce::Array<PresetManager*> managers;
+        };
+
+        void subscribe (PresetManager* manager);
+        void unsubscribe (PresetManager* manager);
+        // On the watcher's thread. `changedFiles` is nullptr for a full scan.
+        void scan (const juce::String& path, const juce::Array<juce::File>* changedFiles);
+
+        // Held while a folder is scanned, so that its managers stay alive
+        juce::CriticalSection lock;
+        // By the full path of the folder
+        std::unordered_map<juce::String, Folder> folders;
+    };
+    juce::SharedResourcePointer<SharedPresetWatchers> sharedPresetWatchers;
 
     //==============================================================================
     bool validatePresetFile (juce::File file);
     bool validatePresetXml (juce::XmlElement const* const presetXml);
     void loadPresetState (juce::XmlElement const* const presetXml);
+    bool loadIndexedPreset (juce::File file);
+    void loadPresetXml (juce::File file, juce::XmlElement const* const presetXml);
+    juce::File getPresetFileForNavigation();
     void loadDefaultFileSafely();
     juce::File getPresetDir();
-    juce::Array<juce::File> scanPresets (juce::File dir, juce::Array<juce::File>& presetFiles);
+    juce::Array<juce::File> scanPresets (juce::File dir);
+    PresetListPtr buildPresetList();
+    PresetListPtr updatePresetList (const juce::Array<juce::File>& changedFiles);
+    PresetListPtr makePresetList (juce::Array<juce::File> factoryPresetFiles, juce::Array<juce::File> userPresetFiles);
+    void publishPresetList (PresetListPtr newPresetList);
+    void handleAsyncUpdate() override;
+    void indexPreset (juce::File file, juce::File categoryRootDir);
+    PresetIndex& getPresetIndex();
+    static int getPresetIdx (const PresetList& list, juce::File file);
     void restorePresetFoldersAndPresetsIfNecessary();
     void restoreDefaultPreset();
     void restoreFactoryPresets();
     void restoreUserPresetFolder();
     void updateCurrentPresetBasedOnProcessorState();
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (PresetManager)
 };
 } // namespace onsen
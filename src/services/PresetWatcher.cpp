@@ -0,0 +1,187 @@
+/*
+  ==============================================================================
+
+   Preset Watcher
+
+  ==============================================================================
+*/
+
+#include "PresetWatcher.h"
+
+#if JUCE_LINUX
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace onsen
+{
+//==============================================================================
+
+PresetWatcher::PresetWatcher (juce::File _dir)
+    : juce::Thread ("Preset Watcher"),
+      dir (_dir),
+      fullScanRequested (false)
+{
+}
+
+PresetWatcher::~PresetWatcher()
+{
+    // Don't kill it while it's writing presets
+    stopThread (-1);
+}
+
+void PresetWatcher::requestFullScan()
+{
+    fullScanRequested = true;
+    if (isThreadRunning())
+        notify();
+    else
+        startThread();
+}
+
+//==============================================================================
+
+void PresetWatcher::run()
+{
+#if JUCE_LINUX
+    if (watchWithInotify())
+        return;
+#endif
+    watchByPolling();
+}
+
+void PresetWatcher::watchByPolling()
+{
+    juce::int64 lastFingerprint = 0;
+    while (! threadShouldExit())
+    {
+        if (fullScanRequested.exchange (false) || getFingerprint() != lastFingerprint)
+        {
+            onFullScan();
+            // Restored presets change it
+            lastFingerprint = getFingerprint();
+        }
+        wait (pollingIntervalMs);
+    }
+}
+
+juce::int64 PresetWatcher::getFingerprint() const
+{
+    // Sum of hashes so that it doesn't depend on the order of the files
+    juce::int64 fingerprint = 0;
+    for (const auto& entry : juce::RangedDirectoryIterator (dir, true, "*.oapreset", juce::File::findFiles))
+    {
+        auto hash = entry.getFile().getFullPathName().hashCode64();
+        hash = hash * 31 + entry.getModificationTime().toMilliseconds();
+        hash = hash * 31 + entry.getFileSize();
+        fingerprint += hash;
+    }
+    return fingerprint;
+}
+
+#if JUCE_LINUX
+//==============================================================================
+
+bool PresetWatcher::watchWithInotify()
+{
+    inotifyFd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0)
+        return false;
+
+    while (! threadShouldExit())
+    {
+        if (fullScanRequested.exchange (false))
+        {
+            onFullScan();
+            // Folders may be restored by the scan
+            rewatch();
+        }
+
+        pollfd pfd { inotifyFd, POLLIN, 0 };
+        if (poll (&pfd, 1, pollTimeoutMs) <= 0)
+            continue;
+
+        juce::Array<juce::File> changedFiles;
+        bool needsFullScan = false;
+        readEvents (changedFiles, needsFullScan);
+        wait (debounceMs);
+        readEvents (changedFiles, needsFullScan);
+
+        if (needsFullScan)
+            fullScanRequested = true;
+        else if (! changedFiles.isEmpty())
+            onFilesChanged (changedFiles);
+    }
+
+    close (inotifyFd);
+    inotifyFd = -1;
+    watchedDirs.clear();
+    return true;
+}
+
+void PresetWatcher::rewatch()
+{
+    for (const auto& watchedDir : watchedDirs)
+        inotify_rm_watch (inotifyFd, watchedDir.first);
+    watchedDirs.clear();
+    addWatches (dir);
+}
+
+void PresetWatcher::addWatches (const juce::File& dirToWatch)
+{
+    constexpr uint32_t mask = IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                              | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+    const int wd = inotify_add_watch (inotifyFd, dirToWatch.getFullPathName().toRawUTF8(), mask);
+    if (wd < 0)
+        return;
+
+    watchedDirs[wd] = dirToWatch;
+    for (const auto& entry : juce::RangedDirectoryIterator (dirToWatch, false, "*", juce::File::findDirectories))
+        addWatches (entry.getFile());
+}
+
+void PresetWatcher::readEvents (juce::Array<juce::File>& changedFiles, bool& needsFullScan)
+{
+    alignas (inotify_event) char buffer[4096];
+    for (;;)
+    {
+        const auto numBytes = read (inotifyFd, buffer, sizeof (buffer));
+        if (numBytes <= 0)
+            return; // No more events
+
+        for (const char* p = buffer; p < buffer + numBytes;)
+        {
+            const auto* event = reinterpret_cast<const inotify_event*> (p);
+            p += sizeof (inotify_event) + event->len;
+
+            if ((event->mask & IN_Q_OVERFLOW) != 0)
+            {
+                needsFullScan = true;
+                continue;
+            }
+            if ((event->mask & IN_IGNORED) != 0)
+            {
+                watchedDirs.erase (event->wd);
+                continue;
+            }
+            auto it = watchedDirs.find (event->wd);
+            if (it == watchedDirs.end())
+                continue;
+
+            const auto parentDir = it->second;
+            if ((event->mask & (IN_ISDIR | IN_DELETE_SELF | IN_MOVE_SELF)) != 0)
+            {
+                // Folders are rarely changed. Simply rescan everything.
+                needsFullScan = true;
+                if ((event->mask & IN_ISDIR) != 0 && (event->mask & (IN_CREATE | IN_MOVED_TO)) != 0)
+                    addWatches (parentDir.getChildFile (event->name));
+                continue;
+            }
+            if (event->len > 0)
+                changedFiles.addIfNotAlreadyThere (parentDir.getChildFile (event->name));
+        }
+    }
+}
+#endif
+} // namespace onsen
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+   Preset Watcher
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+
+namespace onsen
+{
+//==============================================================================
+/*
+PresetWatcher
+
+Background thread which scans the preset folder on request and whenever its
+content is changed. On Linux, changes are watched with inotify and only the
+changed files are reported. On the other platforms the folder is polled and
+any change leads to a full scan.
+
+The callbacks are called on this thread. Set them before requestFullScan().
+*/
+class PresetWatcher : private juce::Thread
+{
+public:
+    PresetWatcher (juce::File _dir);
+    ~PresetWatcher() override;
+
+    /*
+    Starts the thread if it isn't running yet
+    */
+    void requestFullScan();
+
+    //==============================================================================
+    std::function<void()> onFullScan;
+    // Files which are created, modified or removed
+    std::function<void (const juce::Array<juce::File>&)> onFilesChanged;
+
+private:
+    static constexpr int pollingIntervalMs = 1000;
+    static constexpr int pollTimeoutMs = 100;
+    // Saving a file produces several events. Wait a bit so that they are handled at once.
+    static constexpr int debounceMs = 50;
+
+    const juce::File dir;
+    std::atomic<bool> fullScanRequested;
+
+    void run() override;
+    void watchByPolling();
+    juce::int64 getFingerprint() const;
+
+#if JUCE_LINUX
+    int inotifyFd = -1;
+    std::unordered_map<int, juce::File> watchedDirs;
+
+    bool watchWithInotify();
+    void rewatch();
+    void addWatches (const juce::File& dirToWatch);
+    void readEvents (juce::Array<juce::File>& changedFiles, bool& needsFullScan);
+#endif
+
+    JUCE_DECLARE_NON_COPYABLE (PresetWatcher)
+};
+} // namespace onsen
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+   Shared Resources
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace onsen
+{
+//==============================================================================
+// Process-wide registry of immutable resources shared by all plugin instances.
+// A resource is created by `create` on the first request for the key and is
+// released when the last shared_ptr to it is destroyed. Resources are const,
+// so they can be read from any thread without locking.
+class SharedResources
+{
+public:
+    template <typename Resource, typename CreateFunction>
+    static std::shared_ptr<const Resource> get (const std::string& key, CreateFunction create)
+    {
+        auto& registry = getRegistry<Resource>();
+        const std::lock_guard<std::mutex> lock (registry.mutex);
+        auto& weakResource = registry.resources[key];
+        if (auto resource = weakResource.lock())
+        {
+            return resource;
+        }
+        std::shared_ptr<const Resource> resource = create();
+        weakResource = resource;
+        return resource;
+    }
+
+    // Number of the resources of the type which are alive
+    template <typename Resource>
+    static int getNumResources()
+    {
+        auto& registry = getRegistry<Resource>();
+        const std::lock_guard<std::mutex> lock (registry.mutex);
+        int numResources = 0;
+        for (const auto& resource : registry.resources)
+        {
+            if (! resource.second.expired())
+            {
+                ++numResources;
+            }
+        }
+        return numResources;
+    }
+
+private:
+    template <typename Resource>
+    struct Registry
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::weak_ptr<const Resource>> resources;
+    };
+
+    // One registry for each type
+    template <typename Resource>
+    static Registry<Resource>& getRegistry()
+    {
+        static Registry<Resource> registry;
+        return registry;
+    }
+};
+} // namespace onsen
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+   Lock-free ring buffer for a single producer and a single consumer
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace onsen
+{
+//==============================================================================
+// push() is called only from one thread (e.g. the audio thread) and pop() only
+// from another one (e.g. the message thread). Neither of them blocks nor
+// allocates. The indices grow monotonically and wrap by the mask.
+template <typename T, size_t capacity>
+class SpscRingBuffer
+{
+    static_assert (capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity should be a power of 2");
+
+public:
+    // Returns false without writing if the buffer is full.
+    bool push (const T& item) noexcept
+    {
+        const auto w = writeIdx.load (std::memory_order_relaxed);
+        if (w - readIdx.load (std::memory_order_acquire) == capacity)
+        {
+            return false;
+        }
+        items[w & mask] = item;
+        writeIdx.store (w + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false if the buffer is empty.
+    bool pop (T& item) noexcept
+    {
+        const auto r = readIdx.load (std::memory_order_relaxed);
+        if (r == writeIdx.load (std::memory_order_acquire))
+        {
+            return false;
+        }
+        item = items[r & mask];
+        readIdx.store (r + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const noexcept
+    {
+        return writeIdx.load (std::memory_order_acquire) - readIdx.load (std::memory_order_acquire);
+    }
+
+    static constexpr size_t getCapacity() noexcept
+    {
+        return capacity;
+    }
+
+private:
+    static constexpr size_t mask = capacity - 1;
+
+    std::array<T, capacity> items {};
+    // Separate cache lines so that the two threads don't contend on them
+    alignas (64) std::atomic<size_t> writeIdx { 0 };
+    alignas (64) std::atomic<size_t> readIdx { 0 };
+};
+} // namespace onsen
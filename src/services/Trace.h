@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+
+   Scoped trace markers exported as Chrome trace JSON
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SpscRingBuffer.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+//==============================================================================
+// Trace markers are compiled only when OS251_TRACE is 1.
+// Enable it with `-DOS251_TRACE=ON` when configuring CMake.
+#ifndef OS251_TRACE
+#define OS251_TRACE 0
+#endif
+
+namespace onsen
+{
+//==============================================================================
+struct TraceEvent
+{
+    const char* name = nullptr; // Should be a string literal
+    int64_t beginNs = 0;
+    int64_t endNs = 0;
+};
+
+//==============================================================================
+// Each thread records into its own lock-free buffer, so recording never blocks.
+// The buffers of the first few threads are allocated with the tracer, so the
+// first event of the audio thread doesn't allocate. Only the threads after
+// them take the lock to allocate theirs.
+// When a buffer is full, the newer events of the thread are dropped.
+// writeChromeTrace() moves the recorded events to a JSON which
+// chrome://tracing and https://ui.perfetto.dev can open.
+class Tracer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr size_t capacityPerThread = 1 << 16;
+    // e.g. the audio thread, the message thread and a few workers
+    static constexpr int numPreallocatedBuffers = 4;
+
+    Tracer() : id (nextId()), origin (Clock::now()), numClaimedBuffers (0)
+    {
+        for (int i = 0; i < numPreallocatedBuffers; ++i)
+        {
+            preallocatedBuffers[i] = std::make_unique<ThreadBuffer> (i);
+        }
+    }
+
+    static Tracer& getInstance()
+    {
+        static Tracer instance;
+        return instance;
+    }
+
+    int64_t now() const noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds> (Clock::now() - origin).count();
+    }
+
+    void record (const char* name, int64_t beginNs, int64_t endNs)
+    {
+        ThreadBuffer* buffer = getThreadBuffer();
+        if (! buffer->events.push ({ name, beginNs, endNs }))
+        {
+            buffer->numDroppedEvents.fetch_add (1, std::memory_order_relaxed);
+        }
+    }
+
+    // Events are removed from the buffers once they are written.
+    void writeChromeTrace (std::ostream& os)
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+
+        const auto flags = os.flags();
+        const auto precision = os.precision();
+        os << std::fixed << std::setprecision (3);
+
+        uint64_t numDroppedEvents = 0;
+        bool isFirst = true;
+        os << "{\"traceEvents\":[";
+        // The buffers which no thread has claimed are empty
+        for (auto& buffer : preallocatedBuffers)
+        {
+            numDroppedEvents += writeEvents (os, *buffer, isFirst);
+        }
+        for (auto& buffer : extraBuffers)
+        {
+            numDroppedEvents += writeEvents (os, *buffer, isFirst);
+        }
+        os << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"droppedEvents\":" << numDroppedEvents << "}}\n";
+
+        os.flags (flags);
+        os.precision (precision);
+    }
+
+private:
+    struct ThreadBuffer
+    {
+        explicit ThreadBuffer (int index) : threadIndex (index), numDroppedEvents (0) {}
+
+        const int threadIndex;
+        std::atomic<uint64_t> numDroppedEvents;
+        SpscRingBuffer<TraceEvent, capacityPerThread> events;
+    };
+
+    // The cache of getThreadBuffer() is keyed by it, not by the address which
+    // a new tracer can reuse after another one is destroyed
+    const uint64_t id;
+    const Clock::time_point origin;
+    std::mutex mutex;
+    // Kept until the tracer is destroyed so that events of finished threads can be written
+    std::array<std::unique_ptr<ThreadBuffer>, numPreallocatedBuffers> preallocatedBuffers;
+    std::atomic<int> numClaimedBuffers;
+    // For the threads after the preallocated buffers are claimed
+    std::vector<std::unique_ptr<ThreadBuffer>> extraBuffers;
+
+    static uint64_t nextId()
+    {
+        // 0 is never used, so it means no tracer in the cache
+        static std::atomic<uint64_t> lastId { 0 };
+        return lastId.fetch_add (1, std::memory_order_relaxed) + 1;
+    }
+
+    ThreadBuffer* getThreadBuffer()
+    {
+        thread_local uint64_t cachedTracerId = 0;
+        thread_local ThreadBuffer* cachedBuffer = nullptr;
+        if (cachedTracerId != id)
+        {
+            const int index = numClaimedBuffers.fetch_add (1, std::memory_order_relaxed);
+            if (index < numPreallocatedBuffers)
+            {
+                cachedBuffer = preallocatedBuffers[index].get();
+            }
+            else
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                extraBuffers.push_back (std::make_unique<ThreadBuffer> (index));
+                cachedBuffer = extraBuffers.back().get();
+            }
+            cachedTracerId = id;
+        }
+        return cachedBuffer;
+    }
+
+    // Returns the number of the dropped events of the buffer
+    static uint64_t writeEvents (std::ostream& os, ThreadBuffer& buffer, bool& isFirst)
+    {
+        TraceEvent event;
+        while (buffer.events.pop (event))
+        {
+            os << (isFirst ? "\n" : ",\n");
+            isFirst = false;
+            // Complete events. The unit of "ts" and "dur" is microseconds.
+            os << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.threadIndex
+               << ",\"ts\":" << event.beginNs / 1000.0
+               << ",\"dur\":" << (event.endNs - event.beginNs) / 1000.0 << "}";
+        }
+        return buffer.numDroppedEvents.exchange (0);
+    }
+};
+
+//==============================================================================
+class ScopedTrace
+{
+public:
+    explicit ScopedTrace (const char* _name, Tracer& _tracer = Tracer::getInstance())
+        : name (_name),
+          tracer (_tracer),
+          beginNs (tracer.now())
+    {
+    }
+
+    ~ScopedTrace()
+    {
+        tracer.record (name, beginNs, tracer.now());
+    }
+
+    ScopedTrace (const ScopedTrace&) = delete;
+    ScopedTrace& operator= (const ScopedTrace&) = delete;
+
+private:
+    const char* const name;
+    Tracer& tracer;
+    const int64_t beginNs;
+};
+} // namespace onsen
+
+//==============================================================================
+// Records the time from here to the end of the scope as `name`.
+#if OS251_TRACE
+#define OS251_TRACE_CONCAT_IMPL(a, b) a##b
+#define OS251_TRACE_CONCAT(a, b) OS251_TRACE_CONCAT_IMPL (a, b)
+#define OS251_TRACE_SCOPE(name) const onsen::ScopedTrace OS251_TRACE_CONCAT (os251TraceScope, __LINE__) (name)
+// Creates the tracer with its buffers. Call it outside the audio thread,
+// e.g. in prepareToPlay(), so that the first marker doesn't allocate.
+#define OS251_TRACE_PREPARE() onsen::Tracer::getInstance()
+#else
+#define OS251_TRACE_SCOPE(name)
+#define OS251_TRACE_PREPARE()
+#endif
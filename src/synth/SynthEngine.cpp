@@ -8,61 +8,155 @@
 
 #include "SynthEngine.h"
 #include "../dsp/JuceAudioBuffer.h"
+#include "../services/Trace.h"
 
 namespace onsen
 {
 //==============================================================================
-void FancySynth::setCurrentPlaybackSampleRate (double sampleRate)
+template <typename SampleType>
+void FancySynth<SampleType>::setCurrentPlaybackSampleRate (double sampleRate)
 {
     lfo->setCurrentPlaybackSampleRate (sampleRate);
-    chorus.setCurrentPlaybackSampleRate (sampleRate);
-    hpf.setCurrentPlaybackSampleRate (sampleRate);
+    postEffects.setCurrentPlaybackSampleRate (sampleRate);
+    oversampler.reset();
     juce::Synthesiser::setCurrentPlaybackSampleRate (sampleRate);
+    updateVoiceSampleRate();
 }
 
-void FancySynth::setSamplesPerBlock (int samplesPerBlock)
+template <typename SampleType>
+void FancySynth<SampleType>::setOversamplingFactor (int factor)
 {
-    lfo->setSamplesPerBlock (samplesPerBlock);
+    if (factor == oversampler.getFactor())
+        return;
+
+    oversampler.setFactor (factor);
+    updateVoiceSampleRate();
 }
 
-void FancySynth::noteOn (int midiChannel,
-                         int midiNoteNumber,
-                         float velocity)
+template <typename SampleType>
+void FancySynth<SampleType>::updateVoiceSampleRate()
+{
+    const double voiceSampleRate = getSampleRate() * oversampler.getFactor();
+    for (auto* voice : voices)
+        voice->setCurrentPlaybackSampleRate (voiceSampleRate);
+}
+
+template <typename SampleType>
+void FancySynth<SampleType>::noteOn (int midiChannel,
+                                     int midiNoteNumber,
+                                     float velocity)
 {
     lfo->noteOn();
     juce::Synthesiser::noteOn (midiChannel, midiNoteNumber, velocity);
 }
 
-void FancySynth::noteOff (int midiChannel,
-                          int midiNoteNumber,
-                          float velocity,
-                          bool allowTailOff)
+template <typename SampleType>
+void FancySynth<SampleType>::noteOff (int midiChannel,
+                                      int midiNoteNumber,
+                                      float velocity,
+                                      bool allowTailOff)
 {
     lfo->noteOff();
     juce::Synthesiser::noteOff (midiChannel, midiNoteNumber, velocity, allowTailOff);
 }
 
-void FancySynth::allNotesOff (int midiChannel,
-                              bool allowTailOff)
+template <typename SampleType>
+void FancySynth<SampleType>::allNotesOff (int midiChannel,
+                                          bool allowTailOff)
 {
     lfo->allNoteOff();
     juce::Synthesiser::allNotesOff (midiChannel, allowTailOff);
 }
 
 //==============================================================================
-void FancySynth::renderVoices (juce::AudioBuffer<flnum>& outputAudio,
-                               int startSample,
-                               int numSamples)
+template <typename SampleType>
+void FancySynth<SampleType>::renderVoices (juce::AudioBuffer<SampleType>& outputAudio,
+                                           int startSample,
+                                           int numSamples)
 {
-    JuceAudioBuffer outputAudioBuffer (&outputAudio);
-
-    lfo->renderLfo (startSample, numSamples);
-    lfo->renderLfoSync (startSample, numSamples);
-    juce::Synthesiser::renderVoices (outputAudio, startSample, numSamples);
-    hpf.render (&outputAudioBuffer, startSample, numSamples);
-    if (params->chorus()->getChorusOn())
-        chorus.render (&outputAudioBuffer, startSample, numSamples);
-    masterVolume.render (&outputAudioBuffer, startSample, numSamples);
+    OS251_TRACE_SCOPE ("FancySynth::renderVoices");
+    // juce::Synthesiser has already split the host block at the MIDI events
+    while (numSamples > 0)
+    {
+        const int numChunkSamples = std::min (numSamples, internalBlockSize);
+        renderChunk (outputAudio, startSample, numChunkSamples);
+        startSample += numChunkSamples;
+        numSamples -= numChunkSamples;
+    }
 }
 
+// The scratch buffers (the LFO's, the voice bus and the oversampler's) hold
+// only the chunk, so they start from index 0.
+template <typename SampleType>
+void FancySynth<SampleType>::renderChunk (juce::AudioBuffer<SampleType>& outputAudio,
+                                          int startSample,
+                                          int numSamples)
+{
+    jassert (numSamples <= internalBlockSize);
+    JuceAudioBuffer<SampleType> outputAudioBuffer (&outputAudio);
+
+    lfo->renderLfo (0, numSamples);
+    lfo->renderLfoSync (0, numSamples, startSample);
+
+    // Only the oscillators and the filters of the voices run at the higher rate,
+    // because they are where aliasing is created. HPF and chorus stay at the
+    // sample rate after the decimation.
+    const int factor = oversampler.getFactor();
+    jassert (numSamples * factor <= voiceAudio.getNumSamples());
+    const bool isStereo = outputAudio.getNumChannels() >= 2;
+    voiceAudio.clear (0, numSamples * factor);
+    VoiceBus<SampleType> bus { voiceAudio.getWritePointer (monoChannel),
+                               isStereo ? voiceAudio.getWritePointer (leftChannel) : nullptr,
+                               isStereo ? voiceAudio.getWritePointer (rightChannel) : nullptr,
+                               false };
+    for (auto* voice : voices)
+        static_cast<FancySynthVoice<SampleType>*> (voice)->renderToBus (bus, 0, numSamples, factor);
+
+    if (factor > 1)
+    {
+        // The stereo channels are silent after the tail, so they don't need
+        // the decimation
+        if (bus.isStereoUsed)
+        {
+            numStereoTailSamples = internalBlockSize;
+        }
+        else if (numStereoTailSamples > 0)
+        {
+            bus.isStereoUsed = true;
+            numStereoTailSamples = std::max (0, numStereoTailSamples - numSamples);
+        }
+        oversampler.decimate (monoChannel, bus.mono, numSamples);
+        if (bus.isStereoUsed)
+        {
+            oversampler.decimate (leftChannel, bus.left, numSamples);
+            oversampler.decimate (rightChannel, bus.right, numSamples);
+        }
+    }
+    mixVoiceBus (outputAudio, bus, startSample, numSamples);
+
+    postEffects.render (&outputAudioBuffer, startSample, numSamples);
+}
+
+// The voices are summed once into the bus, so the host buffer is written
+// once per channel with a vectorized add.
+template <typename SampleType>
+void FancySynth<SampleType>::mixVoiceBus (juce::AudioBuffer<SampleType>& outputAudio,
+                                          const VoiceBus<SampleType>& bus,
+                                          int startSample,
+                                          int numSamples)
+{
+    for (auto channel = outputAudio.getNumChannels(); --channel >= 0;)
+        outputAudio.addFrom (channel, startSample, voiceAudio, monoChannel, 0, numSamples);
+
+    if (bus.isStereoUsed)
+    {
+        outputAudio.addFrom (0, startSample, voiceAudio, leftChannel, 0, numSamples);
+        outputAudio.addFrom (1, startSample, voiceAudio, rightChannel, 0, numSamples);
+    }
+}
+
+//==============================================================================
+template class FancySynth<float>;
+template class FancySynth<double>;
+
 } // namespace onsen
@@ -8,36 +8,58 @@
 
 #pragma once
 
-#include "../dsp/Chorus.h"
+#include "../dsp/BufferArena.h"
 #include "../dsp/DspCommon.h"
-#include "../dsp/Hpf.h"
 #include "../dsp/IPositionInfo.h"
 #include "../dsp/Lfo.h"
-#include "../dsp/MasterVolume.h"
+#include "../dsp/Oversampler.h"
+#include "../dsp/PostEffects.h"
 #include "SynthParams.h"
 #include "SynthVoice.h"
 #include <JuceHeader.h>
+#include <atomic>
 
 namespace onsen
 {
 //==============================================================================
+template <typename SampleType>
 class FancySynth : public juce::Synthesiser
 {
-    using flnum = float;
-
 public:
+    // The voices and the effects run in chunks of up to this size whatever
+    // the host's block size is, so the scratch buffers are sized once and
+    // stay in L1
+    static constexpr int internalBlockSize = INTERNAL_BLOCK_SIZE;
+
     FancySynth() = delete;
-    FancySynth (SynthParams* const synthParams, Lfo* const _lfo)
+    FancySynth (SynthParams* const synthParams, Lfo<SampleType>* const _lfo)
         : params (synthParams),
           lfo (_lfo),
-          hpf (params->hpf(), 2),
-          chorus(),
-          masterVolume (synthParams->master())
+          postEffects (params->hpf(), params->chorus(), synthParams->master(), 2),
+          oversampler (numVoiceBusChannels),
+          voiceAudio (numVoiceBusChannels, internalBlockSize * Oversampler<SampleType>::maxFactor),
+          numStereoTailSamples (0)
     {
+        lfo->setSamplesPerBlock (internalBlockSize);
     }
 
     void setCurrentPlaybackSampleRate (double sampleRate) override;
-    void setSamplesPerBlock (int samplesPerBlock);
+    // The owner of `arena` places the buffers with placeBuffers() after
+    // setCurrentPlaybackSampleRate()
+    void useBufferArena (BufferArena& arena)
+    {
+        postEffects.useBufferArena (arena);
+    }
+    void placeBuffers (BufferArena::Placer& placer)
+    {
+        postEffects.placeBuffers (placer);
+    }
+    // `factor` should be 1 (no oversampling), 2 or 4.
+    // Call it between blocks.
+    void setOversamplingFactor (int factor);
+    // Voices run at `factor` times of the sample rate while oversampling.
+    // Call it after adding voices.
+    void updateVoiceSampleRate();
     void noteOn (int midiChannel,
                  int midiNoteNumber,
                  float velocity) override;
@@ -50,17 +72,44 @@ public:
 
 private:
     SynthParams* const params;
-    Lfo* const lfo;
-    Hpf hpf;
-    Chorus chorus;
-    MasterVolume masterVolume;
-
-    void renderVoices (juce::AudioBuffer<flnum>& outputAudio,
+    Lfo<SampleType>* const lfo;
+    PostEffects<SampleType> postEffects;
+    Oversampler<SampleType> oversampler;
+    // Channels of VoiceBus. The stereo ones are used only by the voices which
+    // are spread.
+    enum VoiceBusChannel
+    {
+        monoChannel,
+        leftChannel,
+        rightChannel,
+        numVoiceBusChannels
+    };
+    // All the voices accumulate into it, at the oversampled rate while oversampling
+    juce::AudioBuffer<SampleType> voiceAudio;
+    // The stereo channels are decimated for a while after the last voice
+    // spread, so that the tails in the filters' history come out
+    int numStereoTailSamples;
+
+    // Only the overload for SampleType runs the effects.
+    // SynthEngine never passes the other type of buffer.
+    using juce::Synthesiser::renderVoices;
+    void renderVoices (juce::AudioBuffer<SampleType>& outputAudio,
                        int startSample,
                        int numSamples) override;
+    // `numSamples` is up to internalBlockSize
+    void renderChunk (juce::AudioBuffer<SampleType>& outputAudio,
+                      int startSample,
+                      int numSamples);
+    void mixVoiceBus (juce::AudioBuffer<SampleType>& outputAudio,
+                      const VoiceBus<SampleType>& bus,
+                      int startSample,
+                      int numSamples);
 };
 
 //==============================================================================
+// SampleType is the precision of the whole DSP chain, so a host running in
+// double precision renders natively without converting the buffer.
+template <typename SampleType>
 class SynthEngine
 {
 public:
@@ -68,31 +117,46 @@ public:
     SynthEngine (SynthParams* const _synthParams, IPositionInfo* const _positionInfo)
         : synthParams (_synthParams),
           positionInfo (_positionInfo),
+          bufferArena(),
           lfo (synthParams->lfo(), positionInfo),
-          synth (synthParams, &lfo)
+          voiceArena (sizeof (FancySynthVoice<SampleType>), MasterParams::maxNumVoices),
+          synth (synthParams, &lfo),
+          oversamplingFactor (1)
     {
         for (auto i = 0; i < 4; ++i)
-            synth.addVoice (new FancySynthVoice (synthParams, &lfo));
+            synth.addVoice (new (voiceArena) FancySynthVoice<SampleType> (synthParams, &lfo));
 
         synth.addSound (new FancySynthSound());
+        lfo.useBufferArena (bufferArena);
+        synth.useBufferArena (bufferArena);
+        allocateBuffers();
     }
 
-    void prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+    // The engine doesn't depend on the host's block size.
+    // Any size of blocks can be rendered without reallocation.
+    void prepareToPlay ([[maybe_unused]] int samplesPerBlockExpected, double sampleRate)
     {
         synth.setCurrentPlaybackSampleRate (sampleRate);
-        synth.setSamplesPerBlock (samplesPerBlockExpected);
+        // The chorus's delay line depends on the sample rate
+        allocateBuffers();
         midiCollector.reset (sampleRate);
     }
 
     void releaseResources() {}
 
-    void renderNextBlock (juce::AudioBuffer<float>& outputAudio, const juce::MidiBuffer& inputMidi, int startSample, int numSamples)
+    void renderNextBlock (juce::AudioBuffer<SampleType>& outputAudio, const juce::MidiBuffer& inputMidi, int startSample, int numSamples)
     {
+        // Apply the factor only at block boundaries
+        synth.setOversamplingFactor (oversamplingFactor.load());
         synth.renderNextBlock (outputAudio, inputMidi, startSample, numSamples);
     }
 
+    // It can be called from any thread
     void changeNumberOfVoices (int num)
     {
+        // The arena's slots are taken and released under the lock, so that
+        // concurrent changes never give a slot to two voices
+        const juce::ScopedLock sl (synth.getLock());
         int numVoices = synth.getNumVoices();
         if (num == numVoices)
             return;
@@ -104,17 +168,59 @@ public:
         assert (num == synth.getNumVoices());
     }
 
+    // Call it from the audio thread
+    int getNumActiveVoices() const
+    {
+        int numActiveVoices = 0;
+        for (auto i = synth.getNumVoices(); --i >= 0;)
+        {
+            if (synth.getVoice (i)->isVoiceActive())
+                ++numActiveVoices;
+        }
+        return numActiveVoices;
+    }
+
+    // It can be called from any thread.
+    // The new factor is applied from the next block.
+    void setOversamplingFactor (int factor)
+    {
+        oversamplingFactor.store (factor);
+    }
+
+    // Delay of the output by the oversampling in samples, to report to the host
+    int getLatencySamples() const
+    {
+        return static_cast<int> (std::lround (Oversampler<SampleType>::getLatency (oversamplingFactor.load())));
+    }
+
 private:
     SynthParams* const synthParams;
     IPositionInfo* positionInfo;
-    Lfo lfo;
-    FancySynth synth;
+    // The buffers of the LFO and the post effects, allocated together. It
+    // should outlive the objects whose buffers are placed in it.
+    BufferArena bufferArena;
+    Lfo<SampleType> lfo;
+    // All the voices are allocated in it once, so changing the number of
+    // voices doesn't allocate. It should outlive `synth` which deletes them.
+    VoiceArena voiceArena;
+    FancySynth<SampleType> synth;
     juce::MidiMessageCollector midiCollector;
+    std::atomic<int> oversamplingFactor;
+
+    void allocateBuffers()
+    {
+        bufferArena.allocate ([this] (BufferArena::Placer& placer)
+                              {
+                                  lfo.placeBuffers (placer);
+                                  synth.placeBuffers (placer);
+                              });
+    }
 
     void addNumberOfVoices (int num)
     {
         for (auto i = 0; i < num; ++i)
-            synth.addVoice (new FancySynthVoice (synthParams, &lfo));
+            synth.addVoice (new (voiceArena) FancySynthVoice<SampleType> (synthParams, &lfo));
+        synth.updateVoiceSampleRate();
     }
 
     void subNumberOfVoices (int num)
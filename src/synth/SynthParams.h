@@ -15,7 +15,9 @@
 #include "../params/HpfParams.h"
 #include "../params/LfoParams.h"
 #include "../params/MasterParams.h"
+#include "../params/ModulationParams.h"
 #include "../params/OscillatorParams.h"
+#include "../params/UnisonParams.h"
 
 namespace onsen
 {
@@ -23,7 +25,10 @@ namespace onsen
 class SynthParams
 {
 public:
-    SynthParams() = default;
+    SynthParams()
+    {
+        compileModulationMatrix();
+    }
     EnvelopeParams* envelope()
     {
         return &envelopeParams;
@@ -52,6 +57,31 @@ public:
     {
         return &masterParams;
     }
+    ModulationParams* modulation()
+    {
+        return &modulationParams;
+    }
+    UnisonParams* unison()
+    {
+        return &unisonParams;
+    }
+    const ModulationMatrix* modulationMatrix() const
+    {
+        return &matrix;
+    }
+
+    // Collect the modulation depths of the parameters into the matrix.
+    // Call it after the parameters are changed.
+    void compileModulationMatrix()
+    {
+        matrix.setDepth (ModSource::lfo, ModDestination::pitch, lfoParams.getPitch());
+        matrix.setDepth (ModSource::lfo, ModDestination::filterFreq, lfoParams.getFilterFreq());
+        matrix.setDepth (ModSource::lfo, ModDestination::shape, lfoParams.getShape());
+        matrix.setDepth (ModSource::envelope, ModDestination::pitch, modulationParams.getEnvPitch());
+        matrix.setDepth (ModSource::envelope, ModDestination::filterFreq, filterParams.getFilterEnvelope());
+        matrix.setDepth (ModSource::envelope, ModDestination::shape, modulationParams.getEnvShape());
+        matrix.compile();
+    }
 
     void prepareToPlay (int samplesPerBlockExpected, double sampleRate)
     {
@@ -66,5 +96,8 @@ private:
     ChorusParams chorusParams;
     HpfParams hpfParams;
     MasterParams masterParams;
+    ModulationParams modulationParams;
+    UnisonParams unisonParams;
+    ModulationMatrix matrix;
 };
 } // namespace onsen
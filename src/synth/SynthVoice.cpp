@@ -7,17 +7,30 @@
 */
 
 #include "SynthVoice.h"
+#include "../services/Trace.h"
 
 namespace onsen
 {
 //==============================================================================
-bool FancySynthVoice::canPlaySound (juce::SynthesiserSound* sound)
+template <typename SampleType>
+bool FancySynthVoice<SampleType>::canPlaySound (juce::SynthesiserSound* sound)
 {
     return dynamic_cast<FancySynthSound*> (sound) != nullptr;
 }
 
-void FancySynthVoice::setCurrentPlaybackSampleRate (const double newRate)
+template <typename SampleType>
+void FancySynthVoice<SampleType>::setCurrentPlaybackSampleRate (const double newRate)
 {
+    // Keep the pitch of the playing note when the oversampling factor changes the rate
+    const double oldRate = getSampleRate();
+    if (oldRate > 0.0 && newRate > 0.0 && angleDelta != 0.0)
+    {
+        const SampleType ratio = oldRate / newRate;
+        angleDelta *= ratio;
+        smoothedAngleDelta.reset (smoothedAngleDelta.get() * ratio);
+        smoothedAngleDelta.set (angleDelta);
+    }
+
     juce::SynthesiserVoice::setCurrentPlaybackSampleRate (newRate);
     envManager.setCurrentPlaybackSampleRate (newRate);
     filter.setCurrentPlaybackSampleRate (newRate);
@@ -26,16 +39,17 @@ void FancySynthVoice::setCurrentPlaybackSampleRate (const double newRate)
     smoothedAngleDelta.prepareToPlay (newRate);
 }
 
-void FancySynthVoice::startNote (int midiNoteNumber, flnum velocity, juce::SynthesiserSound*, int currentPitchWheelPosition)
+template <typename SampleType>
+void FancySynthVoice<SampleType>::startNote (int midiNoteNumber, float velocity, juce::SynthesiserSound*, int currentPitchWheelPosition)
 {
     setPitchBend (currentPitchWheelPosition);
 
     level = velocity; // The max value of velocity is 1.0
     envManager.noteOn();
 
-    flnum adjustOctave = 2.0;
-    flnum cyclesPerSecond = juce::MidiMessage::getMidiNoteInHertz (midiNoteNumber) / adjustOctave;
-    flnum cyclesPerSample = cyclesPerSecond / getSampleRate();
+    SampleType adjustOctave = 2.0;
+    SampleType cyclesPerSecond = juce::MidiMessage::getMidiNoteInHertz (midiNoteNumber) / adjustOctave;
+    SampleType cyclesPerSample = cyclesPerSecond / getSampleRate();
 
     angleDelta = cyclesPerSample * 2.0 * pi;
     if (isNoteOverlapped)
@@ -47,11 +61,17 @@ void FancySynthVoice::startNote (int midiNoteNumber, flnum velocity, juce::Synth
         smoothedAngleDelta.reset (angleDelta);
     }
 
+    // Don't ramp from the modulation of the previous note
+    shapeMod.reset();
+    pitchMod.reset();
+    filter.resetModulation();
+
     lfo->noteOn();
     isNoteOn = true;
 }
 
-void FancySynthVoice::stopNote (float /*velocity*/, bool allowTailOff)
+template <typename SampleType>
+void FancySynthVoice<SampleType>::stopNote (float /*velocity*/, bool allowTailOff)
 {
     if (allowTailOff)
     {
@@ -71,40 +91,123 @@ void FancySynthVoice::stopNote (float /*velocity*/, bool allowTailOff)
     isNoteOn = false;
 }
 
-void FancySynthVoice::pitchWheelMoved (int newPitchWheelValue)
+template <typename SampleType>
+void FancySynthVoice<SampleType>::pitchWheelMoved (int newPitchWheelValue)
 {
     setPitchBend (newPitchWheelValue);
 }
 
-void FancySynthVoice::renderNextBlock (juce::AudioSampleBuffer& outputBuffer, int startSample, int numSamples)
+template <typename SampleType>
+void FancySynthVoice<SampleType>::renderNextBlock (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
+{
+    renderToBuffer (outputBuffer, startSample, numSamples);
+}
+
+template <typename SampleType>
+void FancySynthVoice<SampleType>::renderNextBlock (juce::AudioBuffer<double>& outputBuffer, int startSample, int numSamples)
+{
+    renderToBuffer (outputBuffer, startSample, numSamples);
+}
+
+template <typename SampleType>
+void FancySynthVoice<SampleType>::renderToBus (VoiceBus<SampleType>& bus, int startSample, int numSamples, int factor)
 {
+    render (bus, 0, numSamples * factor, startSample, factor);
+}
+
+// FancySynth renders the voices with renderToBus(). It's for the other users
+// of juce::SynthesiserVoice, so it goes through a small mono bus on the stack.
+template <typename SampleType>
+template <typename OutputSampleType>
+void FancySynthVoice<SampleType>::renderToBuffer (juce::AudioBuffer<OutputSampleType>& outputBuffer, int startSample, int numSamples)
+{
+    jassert (startSample + numSamples <= lfo->getSamplesPerBlock());
+    constexpr int chunkSize = INTERNAL_BLOCK_SIZE;
+    std::array<SampleType, chunkSize> chunk;
+    while (numSamples > 0)
+    {
+        const int numChunkSamples = std::min (numSamples, chunkSize);
+        chunk.fill (0.0);
+        VoiceBus<SampleType> bus { chunk.data(), nullptr, nullptr, false };
+        render (bus, 0, numChunkSamples, startSample, 1);
+        for (auto i = outputBuffer.getNumChannels(); --i >= 0;)
+        {
+            for (int j = 0; j < numChunkSamples; ++j)
+                outputBuffer.addSample (i, startSample + j, static_cast<OutputSampleType> (chunk[j]));
+        }
+        startSample += numChunkSamples;
+        numSamples -= numChunkSamples;
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void FancySynthVoice<SampleType>::render (VoiceBus<SampleType>& bus, int startSample, int numSamples, int lfoStartSample, int lfoStep)
+{
+    OS251_TRACE_SCOPE ("FancySynthVoice::renderNextBlock");
     int idx = startSample;
+    int lfoIdx = lfoStartSample;
+    int lfoStepCnt = 0;
     if (angleDelta != 0.0)
     {
+        // The control interval is in the synth's samples, so that the control rate
+        // doesn't depend on the oversampling factor
+        const int controlInterval = modParams->getControlInterval() * lfoStep;
+        auto intervalOf = [controlInterval] (ModRate rate) { return rate == ModRate::control ? controlInterval : 1; };
+        shapeMod.setInterval (intervalOf (modParams->getShapeModRate()));
+        pitchMod.setInterval (intervalOf (modParams->getPitchModRate()));
+        filter.setControlInterval (intervalOf (modParams->getFilterModRate()));
+        smoothedAngleDelta.setSmoothness (p->getPortamento());
+        osc.selectKernel (matrix->hasRoutes (ModDestination::shape));
+        unison.set (unisonParams->getNumVoices(), unisonParams->getDetune(), unisonParams->getSpread());
+        const int numUnisonVoices = unison.getNumVoices();
+        // A mono only bus gets the copies without panning
+        const bool renderStereo = unison.isStereo() && bus.left != nullptr;
+        if (renderStereo && ! isStereo)
+        {
+            filter.copyStateToRight();
+        }
+        isStereo = renderStereo;
+        bus.isStereoUsed |= isStereo;
+
         while (--numSamples >= 0)
         {
             envManager.switchTarget (p->getEnvForAmpOn());
-            flnum currentSample = osc.oscillatorVal (
-                currentAngle, lfo->getLevel (idx) * lfo->getShapeAmount());
-            flnum rawAmp = level * envManager.getLevel();
+            const SampleType shapeModulation = shapeMod.next ([this, lfoIdx] {
+                return modulate (ModDestination::shape, lfoIdx);
+            });
+            std::array<SampleType, Unison<SampleType>::maxNumVoices> oscVals;
+            osc.oscillatorVals (unison.getPhases(), oscVals.data(), numUnisonVoices, shapeModulation);
+            SampleType rawAmp = level * envManager.getLevel();
             smoothedAmp.set (rawAmp);
             smoothedAmp.update();
-            currentSample = filter.process (currentSample, idx);
-            currentSample *= smoothedAmp.get();
-
-            for (auto i = outputBuffer.getNumChannels(); --i >= 0;)
-                outputBuffer.addSample (i, idx, currentSample);
+            if (isStereo)
+            {
+                SampleType left, right;
+                unison.mixStereo (oscVals.data(), left, right);
+                filter.processStereo (left, right, lfoIdx);
+                bus.left[idx] += left * smoothedAmp.get();
+                bus.right[idx] += right * smoothedAmp.get();
+            }
+            else
+            {
+                SampleType currentSample = unison.mixMono (oscVals.data());
+                currentSample = filter.process (currentSample, lfoIdx);
+                currentSample *= smoothedAmp.get();
+                bus.mono[idx] += currentSample;
+            }
 
-            flnum lfoPitchDepth = lfo->getPitchAmount();
-            flnum lfoVal = lfo->getLevel (idx);
-            smoothedAngleDelta.setSmoothness (p->getPortamento());
+            const SampleType pitchModulation = pitchMod.next ([this, lfoIdx] {
+                return modulate (ModDestination::pitch, lfoIdx);
+            });
             smoothedAngleDelta.update();
-            currentAngle += smoothedAngleDelta.get() * p->getFreqRatio() * (1.0 * pitchBend + lfoPitchDepth * lfoVal);
-            if (currentAngle > pi * 2.0)
+            unison.advance (smoothedAngleDelta.get() * p->getFreqRatio() * (1.0 * pitchBend + pitchModulation));
+            ++idx;
+            if (++lfoStepCnt == lfoStep)
             {
-                currentAngle -= pi * 2.0;
+                lfoStepCnt = 0;
+                ++lfoIdx;
             }
-            ++idx;
             envManager.update();
             smoothedAmp.update();
             if (envManager.isEnvOff() && smoothedAmp.get() <= 0.001)
@@ -121,13 +224,14 @@ void FancySynthVoice::renderNextBlock (juce::AudioSampleBuffer& outputBuffer, in
 }
 
 //==============================================================================
-void FancySynthVoice::setPitchBend (int pitchWheelValue)
+template <typename SampleType>
+void FancySynthVoice<SampleType>::setPitchBend (int pitchWheelValue)
 {
     // `newPitchWheelValue` is integer from 0 to 16383 (0x3fff).
     // 8192 -> no pitch bend
     if (pitchWheelValue > 8192)
     {
-        pitchBend = 1.0 + (p->getPitchBendWidthInFreqRatio() - 1.0) * (static_cast<flnum> (pitchWheelValue) - 8192.0) / 8191.0; // 16383 - 8192 = 8191
+        pitchBend = 1.0 + (p->getPitchBendWidthInFreqRatio() - 1.0) * (static_cast<SampleType> (pitchWheelValue) - 8192.0) / 8191.0; // 16383 - 8192 = 8191
     }
     else if (pitchWheelValue == 8192)
     {
@@ -135,7 +239,23 @@ void FancySynthVoice::setPitchBend (int pitchWheelValue)
     }
     else
     {
-        pitchBend = 1.0 / (1.0 + (p->getPitchBendWidthInFreqRatio() - 1.0) * (8192.0 - static_cast<flnum> (pitchWheelValue)) / 8192.0);
+        pitchBend = 1.0 / (1.0 + (p->getPitchBendWidthInFreqRatio() - 1.0) * (8192.0 - static_cast<SampleType> (pitchWheelValue)) / 8192.0);
     }
 }
+
+template <typename SampleType>
+SampleType FancySynthVoice<SampleType>::modulate (ModDestination destination, int lfoIdx) const
+{
+    // Unused destinations don't even read the sources
+    if (! matrix->hasRoutes (destination))
+    {
+        return 0.0;
+    }
+    const ModSourceValues<SampleType> sources { lfo->getLevel (lfoIdx), env.getLevel() };
+    return matrix->modulate (destination, sources);
+}
+
+//==============================================================================
+template class FancySynthVoice<float>;
+template class FancySynthVoice<double>;
 } // namespace onsen
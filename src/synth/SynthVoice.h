@@ -10,59 +10,131 @@
 
 #include "../dsp/DspCommon.h"
 #include "../dsp/Filter.h"
+#include "../dsp/Modulation.h"
 #include "../dsp/Oscillator.h"
+#include "../dsp/Phasor.h"
+#include "../dsp/Unison.h"
 #include "SynthParams.h"
 #include "SynthSound.h"
+#include "VoiceArena.h"
 #include <JuceHeader.h>
 
 namespace onsen
 {
 //==============================================================================
+// Scratch bus which all the voices accumulate into.
+// Mono voices write only `mono`. Voices spread over the stereo field write
+// `left` and `right` and set `isStereoUsed`. `left` and `right` are null
+// when the bus is mono only.
+template <typename SampleType>
+struct VoiceBus
+{
+    SampleType* mono;
+    SampleType* left;
+    SampleType* right;
+    bool isStereoUsed;
+};
+
+//==============================================================================
+template <typename SampleType>
 class FancySynthVoice : public juce::SynthesiserVoice
 {
-    using flnum = float;
+    static constexpr SampleType pi = pi_v<SampleType>;
+    static_assert (Unison<SampleType>::maxNumVoices <= Oscillator<SampleType>::maxNumLanes);
+    static_assert (UnisonParams::maxNumVoices <= Unison<SampleType>::maxNumVoices);
 
 public:
     FancySynthVoice() = delete;
-    FancySynthVoice (SynthParams* const synthParams, Lfo* const _lfo)
-        : p (synthParams->master()),
+    FancySynthVoice (SynthParams* const synthParams, Lfo<SampleType>* const _lfo)
+        : unison(),
+          osc (synthParams->oscillator()),
+          filter (synthParams->filter(), synthParams->modulationMatrix(), &env, _lfo),
           smoothedAngleDelta (0.0, 0.0),
           smoothedAmp (0.0, 0.995),
-          osc (synthParams->oscillator()),
+          shapeMod(),
+          pitchMod(),
           env ((IEnvelopeParams*) (synthParams->envelope())),
           gate(),
           envManager (&env, &gate),
+          isStereo (false),
+          p (synthParams->master()),
+          modParams (synthParams->modulation()),
+          matrix (synthParams->modulationMatrix()),
+          unisonParams (synthParams->unison()),
           lfo (_lfo),
-          filter (synthParams->filter(), &env, lfo),
           isNoteOn (false),
           isNoteOverlapped (false)
     {
     }
 
+    // The voices live in a VoiceArena. juce::Synthesiser deletes them.
+    static void* operator new (size_t size, VoiceArena& arena)
+    {
+        return arena.allocate (size);
+    }
+    static void operator delete (void* ptr)
+    {
+        VoiceArena::deallocate (ptr);
+    }
+    // Called when the constructor throws
+    static void operator delete (void* ptr, VoiceArena&)
+    {
+        VoiceArena::deallocate (ptr);
+    }
+
     bool canPlaySound (juce::SynthesiserSound* sound) override;
     void setCurrentPlaybackSampleRate (const double newRate) override;
-    void startNote (int midiNoteNumber, flnum velocity, juce::SynthesiserSound*, int currentPitchWheelPosition) override;
+    void startNote (int midiNoteNumber, float velocity, juce::SynthesiserSound*, int currentPitchWheelPosition) override;
     void stopNote (float /*velocity*/, bool allowTailOff) override;
     void pitchWheelMoved (int newPitchWheelValue) override;
     void controllerMoved (int, int) override {}
-    void renderNextBlock (juce::AudioSampleBuffer& outputBuffer, int startSample, int numSamples) override;
+    // `startSample` is also the index of the LFO's buffer, which holds only
+    // the chunk FancySynth is rendering. So `startSample + numSamples` should
+    // be up to INTERNAL_BLOCK_SIZE.
+    void renderNextBlock (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override;
+    void renderNextBlock (juce::AudioBuffer<double>& outputBuffer, int startSample, int numSamples) override;
+    // Add `numSamples * factor` samples to the start of `bus`.
+    // The sample rate of the voice should be `factor` times of the synth's one.
+    // `startSample` is the position of the block in the LFO's buffer.
+    void renderToBus (VoiceBus<SampleType>& bus, int startSample, int numSamples, int factor);
 
 private:
+    // The state updated every sample comes first from a cache line of its
+    // own, apart from juce::SynthesiserVoice's members and the ones below
+    // which are read once per block or per note.
+    // The phase of the oscillator is the first copy's one
+    alignas (CACHE_LINE_SIZE) Unison<SampleType> unison;
+    Oscillator<SampleType> osc;
+    Filter<SampleType> filter;
+    SmoothValue<SampleType> smoothedAngleDelta;
+    SmoothValue<SampleType> smoothedAmp;
+    ControlRateValue<SampleType> shapeMod;
+    ControlRateValue<SampleType> pitchMod;
+    Envelope<SampleType> env;
+    Gate<SampleType> gate;
+    EnvManager<SampleType> envManager;
+    // We use angle delta in radian
+    SampleType angleDelta = 0.0, level = 0.0;
+    SampleType pitchBend = 1.0;
+    // Whether the last block was rendered in stereo
+    bool isStereo;
+
     MasterParams* const p;
-    // We use angle in radian
-    flnum currentAngle = 0.0, angleDelta = 0.0, level = 0.0;
-    SmoothFlnum smoothedAngleDelta;
-    SmoothFlnum smoothedAmp;
-    flnum pitchBend = 1.0;
-    Oscillator osc;
-    Envelope env;
-    Gate gate;
-    EnvManager envManager;
-    Lfo* const lfo;
-    Filter filter;
+    const IModulationParams* const modParams;
+    const ModulationMatrix* const matrix;
+    const IUnisonParams* const unisonParams;
+    Lfo<SampleType>* const lfo;
     bool isNoteOn;
     bool isNoteOverlapped;
 
+    // The LFO is rendered at the synth's sample rate, so its index moves
+    // once per `lfoStep` samples.
+    void render (VoiceBus<SampleType>& bus, int startSample, int numSamples, int lfoStartSample, int lfoStep);
+    // Both overloads of renderNextBlock() share it, so the DSP always runs in
+    // SampleType whatever the type of the output buffer is.
+    template <typename OutputSampleType>
+    void renderToBuffer (juce::AudioBuffer<OutputSampleType>& outputBuffer, int startSample, int numSamples);
     void setPitchBend (int pitchWheelValue);
+    SampleType modulate (ModDestination destination, int lfoIdx) const;
 };
 } // namespace onsen
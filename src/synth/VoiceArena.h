@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+   Voice arena
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../dsp/DspCommon.h"
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace onsen
+{
+//==============================================================================
+// One allocation for all the voices of an engine.
+// Each voice gets a slot starting at a cache line, so the voices rendered one
+// after another are next to each other in memory and no two share a line.
+// The freed slots are reused from the lowest one to keep the voices packed.
+// A slot begins with a cache line of header which points back to the arena,
+// so that `operator delete` of a voice can return its slot.
+// It isn't thread-safe. Create and delete the voices under the lock of the
+// synthesiser which owns them.
+class VoiceArena
+{
+public:
+    VoiceArena() = delete;
+    VoiceArena (size_t voiceSize, int _numSlots)
+        : slotSize (roundUpToCacheLine (headerSize + voiceSize)),
+          numSlots (_numSlots),
+          storage (static_cast<std::byte*> (::operator new (slotSize * numSlots, std::align_val_t (CACHE_LINE_SIZE)))),
+          isUsed (numSlots, 0)
+    {
+    }
+
+    ~VoiceArena()
+    {
+        // The voices should be deleted before
+        assert (std::find (isUsed.begin(), isUsed.end(), 1) == isUsed.end());
+        ::operator delete (storage, std::align_val_t (CACHE_LINE_SIZE));
+    }
+
+    VoiceArena (const VoiceArena&) = delete;
+    VoiceArena& operator= (const VoiceArena&) = delete;
+
+    // It throws std::bad_alloc when all the slots are used
+    void* allocate (size_t size)
+    {
+        assert (headerSize + size <= slotSize);
+        for (int i = 0; i < numSlots; ++i)
+        {
+            if (! isUsed[i])
+            {
+                isUsed[i] = 1;
+                std::byte* slot = storage + i * slotSize;
+                new (slot) Header { this, i };
+                return slot + headerSize;
+            }
+        }
+        throw std::bad_alloc();
+    }
+
+    // `ptr` is returned by allocate() of any arena
+    static void deallocate (void* ptr)
+    {
+        const Header* header = reinterpret_cast<const Header*> (static_cast<std::byte*> (ptr) - headerSize);
+        header->arena->isUsed[header->slot] = 0;
+    }
+
+    int getNumSlots() const
+    {
+        return numSlots;
+    }
+
+private:
+    struct Header
+    {
+        VoiceArena* arena;
+        int slot;
+    };
+    static constexpr size_t headerSize = CACHE_LINE_SIZE;
+    static_assert (sizeof (Header) <= headerSize);
+
+    const size_t slotSize;
+    const int numSlots;
+    std::byte* const storage;
+    // Not std::vector<bool>, whose flags share words
+    std::vector<char> isUsed;
+};
+} // namespace onsen
@@ -32,6 +32,7 @@ PresetManagerView::PresetManagerView (PresetManager& _presetManager)
       saveAsItem(),
       goToPresetFolderItem(),
       rescanPresetsItem(),
+      presetList (presetManager.getPresetList()),
       doNothingOnPresetMenuChangeCallback (false)
 {
     prevButton.setImages (
@@ -96,11 +97,18 @@ PresetManagerView::PresetManagerView (PresetManager& _presetManager)
     presetManager.onNeedToUpdateUI = [this] {
         selectCurrentPreset();
     };
+    presetManager.onPresetListChanged = [this] {
+        loadPresetMenu();
+        selectCurrentPreset();
+    };
+    // The menu is reloaded when the scan is done
+    presetManager.scanPresetsAsync();
 }
 
 PresetManagerView::~PresetManagerView()
 {
     presetManager.onNeedToUpdateUI = nullptr;
+    presetManager.onPresetListChanged = nullptr;
     prevButton.removeListener (this);
     nextButton.removeListener (this);
     reloadButton.removeListener (this);
@@ -129,7 +137,7 @@ void PresetManagerView::buttonClicked (juce::Button* button)
 
     if (button == &reloadButton)
     {
-        presetManager.loadPreset (presetManager.getCurrentPresetFile());
+        presetManager.loadPresetAsync (presetManager.getCurrentPresetFile());
         selectCurrentPreset();
     }
 }
@@ -177,11 +185,13 @@ void PresetManagerView::createPresetMenuTree (juce::PopupMenu& menu,
 
 void PresetManagerView::loadPresetMenu()
 {
-    // TODO: Need acync IO for scanning presets?
-    presetManager.scanPresets();
+    // Keep the list which the menu is built from
+    presetList = presetManager.getPresetList();
     presetMenu.clear (juce::NotificationType::dontSendNotification);
     factoryPresetMenu.clear();
     userPresetMenu.clear();
+    itemIdByPreset.clear();
+    presetByItemId.clear();
     int itemId = 1; // Item ID should start from 1
 
     // Default preset
@@ -191,7 +201,7 @@ void PresetManagerView::loadPresetMenu()
     itemId++;
 
     // Factory presets
-    auto factoryPresetFiles = presetManager.getFactoryPresets();
+    auto factoryPresetFiles = presetList->factoryPresetFiles;
     {
         int i = 0;
         createPresetMenuTree (factoryPresetMenu, itemId, factoryPresetFiles, i, presetManager.getFactoryPresetDir());
@@ -199,7 +209,7 @@ void PresetManagerView::loadPresetMenu()
     presetMenu.getRootMenu()->addSubMenu ("Factory Presets", factoryPresetMenu);
 
     // User presets
-    auto userPresetFiles = presetManager.getUserPresets();
+    auto userPresetFiles = presetList->userPresetFiles;
     {
         int i = 0;
         createPresetMenuTree (userPresetMenu, itemId, userPresetFiles, i, presetManager.getUserPresetDir());
@@ -316,18 +326,18 @@ void PresetManagerView::presetMenuChanged()
     // Even when this callback is triggered by operation menu,
     // selectedItemId is already changed back by them.
     assert (! isPresetOperationItem (selectedItemId));
-    presetManager.loadPreset (presetByItemId[selectedItemId]);
+    presetManager.loadPresetAsync (presetByItemId[selectedItemId]);
 }
 
 void PresetManagerView::prevClicked()
 {
-    presetManager.loadPrev();
+    presetManager.loadPrevAsync();
     selectCurrentPreset();
 }
 
 void PresetManagerView::nextClicked()
 {
-    presetManager.loadNext();
+    presetManager.loadNextAsync();
     selectCurrentPreset();
 }
 
@@ -360,7 +370,7 @@ void PresetManagerView::saveAsClicked()
             return;
         }
         presetManager.savePreset (file);
-        loadPresetMenu();
+        presetManager.scanPresetsAsync();
         selectCurrentPreset();
     });
 }
@@ -379,7 +389,7 @@ void PresetManagerView::goToPresetFolderClicked()
 
 void PresetManagerView::rescanPresetsClicked()
 {
-    loadPresetMenu();
+    presetManager.scanPresetsAsync();
     selectCurrentPreset();
 }
 
@@ -410,7 +420,7 @@ int PresetManagerView::presetMenuItemId (int presetArrayIdx)
 
 bool PresetManagerView::isPresetOperationItem (int selectedItemId)
 {
-    auto presetFiles = presetManager.getPresets();
+    auto presetFiles = presetList->presetFiles;
     int lastPresetItemId = presetMenuItemId (presetFiles.size() - 1);
     /*
         Note that our preset menu looks like...
@@ -76,6 +76,7 @@ private:
     juce::PopupMenu::Item saveAsItem;
     juce::PopupMenu::Item goToPresetFolderItem;
     juce::PopupMenu::Item rescanPresetsItem;
+    PresetManager::PresetListPtr presetList;
     bool doNothingOnPresetMenuChangeCallback;
     //==============================================================================
     /*
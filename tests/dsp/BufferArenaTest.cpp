@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+   Buffer arena test
+
+  ==============================================================================
+*/
+
+#include "../../src/dsp/BufferArena.h"
+#include <cstdint>
+#include <gtest/gtest.h>
+
+namespace onsen
+{
+//==============================================================================
+// Buffer arena
+
+TEST (BufferArenaTest, PlacesBuffersAtCacheLines)
+{
+    BufferArena arena;
+    ArenaBuffer<float> a;
+    ArenaBuffer<double> b;
+    ArenaBuffer<float> empty;
+    arena.allocate ([&] (BufferArena::Placer& placer)
+                    {
+                        placer.place (a, 3);
+                        placer.place (empty, 0);
+                        placer.place (b, 20);
+                    });
+
+    EXPECT_EQ (a.size(), 3u);
+    EXPECT_EQ (b.size(), 20u);
+    EXPECT_EQ (empty.size(), 0u);
+    EXPECT_EQ (reinterpret_cast<std::uintptr_t> (a.data()) % CACHE_LINE_SIZE, 0u);
+    EXPECT_EQ (reinterpret_cast<std::uintptr_t> (b.data()) % CACHE_LINE_SIZE, 0u);
+    // `a` takes one cache line and `empty` none
+    EXPECT_EQ (reinterpret_cast<std::byte*> (b.data()) - reinterpret_cast<std::byte*> (a.data()),
+               static_cast<std::ptrdiff_t> (CACHE_LINE_SIZE));
+    EXPECT_EQ (arena.getNumBytes(), CACHE_LINE_SIZE + roundUpToCacheLine (20 * sizeof (double)));
+}
+
+TEST (BufferArenaTest, BuffersAreZeroedOnEveryAllocation)
+{
+    BufferArena arena;
+    ArenaBuffer<float> buf;
+    size_t size = 10;
+    auto placeAll = [&] (BufferArena::Placer& placer) { placer.place (buf, size); };
+
+    arena.allocate (placeAll);
+    for (size_t i = 0; i < buf.size(); ++i)
+        buf[i] = 1.0f;
+    size = 100;
+    arena.allocate (placeAll);
+
+    ASSERT_EQ (buf.size(), 100u);
+    for (size_t i = 0; i < buf.size(); ++i)
+        EXPECT_EQ (buf[i], 0.0f);
+}
+
+TEST (BufferArenaTest, SharedLocalArenaDoesNotAllocate)
+{
+    BufferArena shared;
+    LocalBufferArena local;
+    ArenaBuffer<float> buf;
+    auto placeAll = [&] (BufferArena::Placer& placer) { placer.place (buf, 8); };
+
+    local.allocate (placeAll);
+    ASSERT_EQ (buf.size(), 8u);
+    float* ownData = buf.data();
+
+    local.share (shared);
+    shared.allocate (placeAll);
+    EXPECT_NE (buf.data(), ownData);
+    float* sharedData = buf.data();
+    // The owner of the shared arena places the buffer
+    local.allocate (placeAll);
+    EXPECT_EQ (buf.data(), sharedData);
+}
+} // namespace onsen
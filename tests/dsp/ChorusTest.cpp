@@ -31,8 +31,8 @@ protected:
     static constexpr int numChannel = 2;
     static constexpr int samplesPerBlock = 2048; // Require more that the chorus' buffer size
 
-    Chorus chorus;
-    AudioBufferMock audioBuffer { numChannel, samplesPerBlock };
+    Chorus<flnum> chorus;
+    AudioBufferMock<flnum> audioBuffer { numChannel, samplesPerBlock };
 };
 
 TEST_F (ChorusTest, Snapshot)
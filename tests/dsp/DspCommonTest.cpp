@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+   DSP Common Test
+
+  ==============================================================================
+*/
+
+#include "../../src/dsp/DspCommon.h"
+#include <cmath>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace onsen
+{
+//==============================================================================
+// DspMath
+
+TEST (DspMathTest, FastSinCos)
+{
+    for (double x = -8192.0; x <= 8192.0; x += 0.01)
+    {
+        const auto xf = static_cast<flnum> (x);
+        EXPECT_NEAR (DspMath::fastSin (xf), std::sin (static_cast<double> (xf)), 3e-7);
+        EXPECT_NEAR (DspMath::fastCos (xf), std::cos (static_cast<double> (xf)), 3e-7);
+    }
+}
+
+TEST (DspMathTest, FastTan)
+{
+    for (double x = -pi / 2.0 + 0.01; x <= pi / 2.0 - 0.01; x += 0.0001)
+    {
+        const auto xf = static_cast<flnum> (x);
+        const double expected = std::tan (static_cast<double> (xf));
+        const double maxError = std::abs (x) <= pi / 4.0 ? 4e-7 : 2e-5;
+        EXPECT_NEAR (DspMath::fastTan (xf) / expected, 1.0, maxError);
+    }
+}
+
+TEST (DspMathTest, FastExp2)
+{
+    for (double x = -126.0; x <= 127.0; x += 0.001)
+    {
+        const auto xf = static_cast<flnum> (x);
+        const double expected = std::exp2 (static_cast<double> (xf));
+        EXPECT_NEAR (DspMath::fastExp2 (xf) / expected, 1.0, 2.5e-7);
+    }
+}
+
+TEST (DspMathTest, FastLog2)
+{
+    for (double x = 1e-30; x <= 1e30; x *= 1.001)
+    {
+        const auto xf = static_cast<flnum> (x);
+        const double expected = std::log2 (static_cast<double> (xf));
+        if (x >= 0.5 && x <= 2.0)
+            EXPECT_NEAR (DspMath::fastLog2 (xf), expected, 1.5e-7);
+        else
+            EXPECT_NEAR (DspMath::fastLog2 (xf) / expected, 1.0, 1.1e-7);
+    }
+}
+
+TEST (DspMathTest, BlocksMatchScalar)
+{
+    constexpr int numSamples = 67; // Not multiple of SIMD width
+    std::vector<flnum> in (numSamples);
+    std::vector<flnum> out (numSamples);
+    for (int i = 0; i < numSamples; ++i)
+        in[i] = static_cast<flnum> (i - numSamples / 2) * 0.37f;
+
+    DspMath::fastSinBlock (in.data(), out.data(), numSamples);
+    for (int i = 0; i < numSamples; ++i)
+        EXPECT_NEAR (out[i], DspMath::fastSin (in[i]), 1e-6);
+
+    DspMath::fastCosBlock (in.data(), out.data(), numSamples);
+    for (int i = 0; i < numSamples; ++i)
+        EXPECT_NEAR (out[i], DspMath::fastCos (in[i]), 1e-6);
+
+    DspMath::fastExp2Block (in.data(), out.data(), numSamples);
+    for (int i = 0; i < numSamples; ++i)
+        EXPECT_FLOAT_EQ (out[i], DspMath::fastExp2 (in[i]));
+
+    for (auto& v : in)
+        v = std::abs (v) + 0.01f;
+    DspMath::fastLog2Block (in.data(), out.data(), numSamples);
+    for (int i = 0; i < numSamples; ++i)
+        EXPECT_FLOAT_EQ (out[i], DspMath::fastLog2 (in[i]));
+}
+
+//==============================================================================
+// SmoothValue
+
+TEST (SmoothValueTest, AdvanceMatchesUpdate)
+{
+    SmoothValue<double> stepped (0.0, 0.99);
+    SmoothValue<double> advanced (0.0, 0.99);
+    stepped.set (0.0);
+    advanced.set (0.0);
+    stepped.set (1.0);
+    advanced.set (1.0);
+
+    for (int i = 0; i < 100; ++i)
+        stepped.update();
+    advanced.advance (100);
+    EXPECT_NEAR (advanced.get(), stepped.get(), 1e-12);
+    EXPECT_NEAR (advanced.get(), 1.0 - std::pow (0.99, 100), 1e-12);
+    EXPECT_FALSE (advanced.isSettled());
+}
+
+TEST (SmoothValueTest, SettlesAtTarget)
+{
+    // Rounding would get it stuck short of the target with a slow smoothing
+    SmoothValue<flnum> value (0.0, 0.99999);
+    value.set (0.0);
+    value.set (0.01);
+    for (int i = 0; i < 5000000 && ! value.isSettled(); ++i)
+        value.update();
+    EXPECT_TRUE (value.isSettled());
+    EXPECT_EQ (value.get(), 0.01f);
+
+    // Settled values don't move
+    value.update();
+    value.advance (512);
+    EXPECT_EQ (value.get(), 0.01f);
+}
+} // namespace onsen
@@ -15,7 +15,8 @@ namespace onsen
 //==============================================================================
 // Envelope
 
-void updateEnv (IEnvelope* env, int times)
+template <typename SampleType>
+void updateEnv (IEnvelope<SampleType>* env, int times)
 {
     for (int i = 0; i < times; i++)
     {
@@ -36,7 +37,7 @@ protected:
     // 1 sec per one env.update()
     static constexpr double sampleRate = 1.0;
     EnvelopeParamsMock envParams;
-    Envelope env { &envParams };
+    Envelope<flnum> env { &envParams };
 };
 
 TEST_F (EnvelopeTest, NoteOn)
@@ -120,7 +121,7 @@ protected:
 
     // void TearDown() override {}
 
-    Gate gate;
+    Gate<flnum> gate;
 
     // NOTE: Following variables is available only for current implementation
     // Requires 2 samples to finish atack (When attack is 0.002 sec)
@@ -191,9 +192,9 @@ protected:
 
     // 1 sec per one env.update()
     EnvelopeParamsMock envParams;
-    Envelope env { (IEnvelopeParams*) (&envParams) };
-    Gate gate;
-    EnvManager envManager { &env, &gate };
+    Envelope<flnum> env { (IEnvelopeParams*) (&envParams) };
+    Gate<flnum> gate;
+    EnvManager<flnum> envManager { &env, &gate };
 
     // NOTE: Following variables is available only for current implementation
     // Requires 2 samples to finish gate's atack (When attack is 0.002 sec)
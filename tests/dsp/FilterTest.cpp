@@ -27,6 +27,9 @@ protected:
         lfo.setCurrentPlaybackSampleRate (sampleRate);
         lfo.setSamplesPerBlock (samplesPerBlock);
         lfo.renderLfo (0, samplesPerBlock - 1);
+        matrix.setDepth (ModSource::lfo, ModDestination::filterFreq, lfoParams.getFilterFreq());
+        matrix.setDepth (ModSource::envelope, ModDestination::filterFreq, filterParams.getFilterEnvelope());
+        matrix.compile();
         filter.setCurrentPlaybackSampleRate (sampleRate);
         filter.resetBuffer();
     }
@@ -39,10 +42,11 @@ protected:
     LfoParamsMock lfoParams { 0.5 /*[Hz]*/, 1.0 / 48.0 /*[bar]*/, 0.0 /*[rad]*/, 0.0001 /*no unit*/, false, 0.51, 0.52, 0.53 };
     FilterParamsMock filterParams;
     PositionInfoMock positionInfo;
+    ModulationMatrix matrix;
 
-    Envelope env { &envParams };
-    Lfo lfo { &lfoParams, &positionInfo };
-    Filter filter { &filterParams, &env, &lfo };
+    Envelope<flnum> env { &envParams };
+    Lfo<flnum> lfo { &lfoParams, &positionInfo };
+    Filter<flnum> filter { &filterParams, &matrix, &env, &lfo };
 };
 
 TEST_F (FilterTest, Snapshot)
@@ -51,4 +55,59 @@ TEST_F (FilterTest, Snapshot)
     EXPECT_FLOAT_EQ (filter.process (0.99, 1), 0.00011064461);
     EXPECT_FLOAT_EQ (filter.process (-0.5, 2), 0.00029543752);
 }
+
+// Filter<double> is the reference of Filter<float>
+TEST_F (FilterTest, FloatMatchesDouble)
+{
+    Envelope<double> envDouble { &envParams };
+    Lfo<double> lfoDouble { &lfoParams, &positionInfo };
+    Filter<double> filterDouble { &filterParams, &matrix, &envDouble, &lfoDouble };
+    envDouble.setCurrentPlaybackSampleRate (sampleRate);
+    lfoDouble.setCurrentPlaybackSampleRate (sampleRate);
+    lfoDouble.setSamplesPerBlock (samplesPerBlock);
+    lfoDouble.renderLfo (0, samplesPerBlock - 1);
+    filterDouble.setCurrentPlaybackSampleRate (sampleRate);
+    filterDouble.resetBuffer();
+
+    for (int i = 0; i < samplesPerBlock - 1; ++i)
+    {
+        const double in = std::sin (i * 0.05) * 0.8;
+        const double outDouble = filterDouble.process (in, i);
+        const flnum outFloat = filter.process (static_cast<flnum> (in), i);
+        EXPECT_NEAR (outFloat, outDouble, 1e-4);
+    }
+}
+
+// Steady modulation gives the same coefficients at control rate
+TEST_F (FilterTest, ControlRateMatchesAudioRate)
+{
+    Filter<flnum> controlRateFilter { &filterParams, &matrix, &env, &lfo };
+    controlRateFilter.setCurrentPlaybackSampleRate (sampleRate);
+    controlRateFilter.setControlInterval (16);
+
+    for (int i = 0; i < samplesPerBlock - 1; ++i)
+    {
+        const flnum in = std::sin (i * 0.05f) * 0.8f;
+        EXPECT_NEAR (controlRateFilter.process (in, i), filter.process (in, i), 1e-6);
+    }
+}
+
+// Each channel of processStereo() is filtered like process()
+TEST_F (FilterTest, StereoMatchesMono)
+{
+    Filter<flnum> stereoFilter { &filterParams, &matrix, &env, &lfo };
+    stereoFilter.setCurrentPlaybackSampleRate (sampleRate);
+    stereoFilter.resetBuffer();
+
+    for (int i = 0; i < samplesPerBlock - 1; ++i)
+    {
+        const flnum in = std::sin (i * 0.05f) * 0.8f;
+        flnum left = in;
+        flnum right = -in;
+        stereoFilter.processStereo (left, right, i);
+        const flnum out = filter.process (in, i);
+        EXPECT_EQ (left, out);
+        EXPECT_EQ (right, -out);
+    }
+}
 } // namespace onsen
@@ -31,9 +31,9 @@ protected:
 TEST_F (HpfTest, SnapshotFor1Ch)
 {
     const int numChannels = 1;
-    Hpf hpf { &hpfParam, numChannels };
+    Hpf<flnum> hpf { &hpfParam, numChannels };
     hpf.setCurrentPlaybackSampleRate (sampleRate);
-    AudioBufferMock audioBuffer { numChannels, samplesPerBlock };
+    AudioBufferMock<flnum> audioBuffer { numChannels, samplesPerBlock };
     setTestInput1 (&audioBuffer);
     hpf.render (&audioBuffer, 0, samplesPerBlock);
 
@@ -46,9 +46,9 @@ TEST_F (HpfTest, SnapshotFor1Ch)
 TEST_F (HpfTest, SnapshotFor2Ch)
 {
     const int numChannels = 2;
-    Hpf hpf { &hpfParam, numChannels };
+    Hpf<flnum> hpf { &hpfParam, numChannels };
     hpf.setCurrentPlaybackSampleRate (sampleRate);
-    AudioBufferMock audioBuffer { numChannels, samplesPerBlock };
+    AudioBufferMock<flnum> audioBuffer { numChannels, samplesPerBlock };
     setTestInput1 (&audioBuffer);
     hpf.render (&audioBuffer, 0, samplesPerBlock);
 
@@ -27,7 +27,7 @@ TEST (LfoTest, GetPitchAmount)
 {
     LfoParamsMock params { 0.5 /*[Hz]*/, 1.0 / 48.0 /*[bar]*/, 0.0 /*[rad]*/, 0.0001 /*no unit*/, false, 0.51, 0.52, 0.53 };
     PositionInfoMock positionInfo;
-    Lfo lfo (&params, &positionInfo);
+    Lfo<flnum> lfo (&params, &positionInfo);
     EXPECT_FLOAT_EQ (lfo.getPitchAmount(), 0.51);
 }
 
@@ -35,7 +35,7 @@ TEST (LfoTest, GetFilterFreqAmount)
 {
     LfoParamsMock params { 0.5 /*[Hz]*/, 1.0 / 48.0 /*[bar]*/, 0.0 /*[rad]*/, 0.0001 /*no unit*/, false, 0.51, 0.52, 0.53 };
     PositionInfoMock positionInfo;
-    Lfo lfo (&params, &positionInfo);
+    Lfo<flnum> lfo (&params, &positionInfo);
     EXPECT_FLOAT_EQ (lfo.getFilterFreqAmount(), 0.52);
 }
 
@@ -43,7 +43,7 @@ TEST (LfoTest, GetShapeAmount)
 {
     LfoParamsMock params { 0.5 /*[Hz]*/, 1.0 / 48.0 /*[bar]*/, 0.0 /*[rad]*/, 0.0001 /*no unit*/, false, 0.51, 0.52, 0.53 };
     PositionInfoMock positionInfo;
-    Lfo lfo (&params, &positionInfo);
+    Lfo<flnum> lfo (&params, &positionInfo);
     EXPECT_FLOAT_EQ (lfo.getShapeAmount(), 0.53);
 }
 
@@ -51,7 +51,7 @@ TEST (LfoTest, WaveFormSnapshotWithoutSync)
 {
     LfoParamsMock params { 0.5 /*[Hz]*/, 1.0 /*[bar]*/, 0.0 /*[rad]*/, 0.0001 /*no unit*/, false, 0.51, 0.52, 0.53 };
     PositionInfoMock positionInfo;
-    Lfo lfo (&params, &positionInfo);
+    Lfo<flnum> lfo (&params, &positionInfo);
 
     // Prepare 1 second buffer
     lfo.setSamplesPerBlock (512);
@@ -70,7 +70,7 @@ TEST (LfoTest, WaveFormSnapshotWithSync)
     LfoParamsMock params { 0.5 /*[Hz]*/, 1.0 /*[bar]*/, 0.0 /*[rad]*/, 0.0001 /*no unit*/, true, 0.51, 0.52, 0.53 };
     PositionInfoMock positionInfo;
     EXPECT_NEAR (positionInfo.getBpm(), 120.0, EPSILON); // So LFO rate (sync) should be 0.5 [Hz]
-    Lfo lfo (&params, &positionInfo);
+    Lfo<flnum> lfo (&params, &positionInfo);
 
     // Prepare 1 second buffer
     lfo.setSamplesPerBlock (512);
@@ -89,7 +89,7 @@ TEST (LfoTest, LfoOnOff1)
     LfoParamsMock params { 0.5 /*[Hz]*/, 1.0 /*[bar]*/, 0.0 /*[rad]*/, 0.0001 /*no unit*/, false, 0.51, 0.52, 0.53 };
     PositionInfoMock positionInfo;
     EXPECT_NEAR (positionInfo.getBpm(), 120.0, EPSILON); // So LFO rate (sync) should be 0.5 [Hz]
-    Lfo lfo (&params, &positionInfo);
+    Lfo<flnum> lfo (&params, &positionInfo);
 
     // Prepare 1 second buffer
     lfo.setSamplesPerBlock (512);
@@ -109,7 +109,7 @@ TEST (LfoTest, LfoOnOff2)
     LfoParamsMock params { 0.5 /*[Hz]*/, 1.0 /*[bar]*/, 0.0 /*[rad]*/, 0.0001 /*no unit*/, false, 0.51, 0.52, 0.53 };
     PositionInfoMock positionInfo;
     EXPECT_NEAR (positionInfo.getBpm(), 120.0, EPSILON); // So LFO rate (sync) should be 0.5 [Hz]
-    Lfo lfo (&params, &positionInfo);
+    Lfo<flnum> lfo (&params, &positionInfo);
 
     // Prepare 1 second buffer
     lfo.setSamplesPerBlock (512);
@@ -131,7 +131,7 @@ TEST (LfoTest, LfoDelay)
     LfoParamsMock params { 0.5 /*[Hz]*/, 1.0 /*[bar]*/, 0.0 /*[rad]*/, 0.99995 /*no unit*/, false, 0.51, 0.52, 0.53 };
     PositionInfoMock positionInfo;
     EXPECT_NEAR (positionInfo.getBpm(), 120.0, EPSILON); // So LFO rate (sync) should be 0.5 [Hz]
-    Lfo lfo (&params, &positionInfo);
+    Lfo<flnum> lfo (&params, &positionInfo);
 
     // Prepare 1 second buffer
     lfo.setSamplesPerBlock (512);
@@ -148,7 +148,7 @@ TEST (LfoTest, Phase)
     LfoParamsMock params { 0.5 /*[Hz]*/, 1.0 /*[bar]*/, pi / 2.0 /*[rad]*/, 0.0001 /*no unit*/, false, 0.51, 0.52, 0.53 };
     PositionInfoMock positionInfo;
     EXPECT_NEAR (positionInfo.getBpm(), 120.0, EPSILON); // So LFO rate (sync) should be 0.5 [Hz]
-    Lfo lfo (&params, &positionInfo);
+    Lfo<flnum> lfo (&params, &positionInfo);
 
     // Prepare 1 second buffer
     lfo.setSamplesPerBlock (512);
@@ -10,6 +10,8 @@
 #include "../../src/params/MasterParamsMock.h"
 #include "util/AudioBufferMock.h"
 #include "util/TestAudioBufferInput.h"
+#include <cmath>
+#include <complex>
 #include <gtest/gtest.h>
 
 namespace onsen
@@ -34,8 +36,8 @@ protected:
     // This value depends on MasterVolume implementation.
     static constexpr flnum clippingValue = 2.0;
     MasterParamsMock masterParam { false, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
-    AudioBufferMock audioBuffer { numChannels, samplesPerBlock };
-    MasterVolume masterVolume { &masterParam };
+    AudioBufferMock<flnum> audioBuffer { numChannels, samplesPerBlock };
+    MasterVolume<flnum> masterVolume { &masterParam, numChannels };
 };
 
 TEST_F (MasterVolumeTest, Volume0db)
@@ -119,4 +121,103 @@ TEST_F (MasterVolumeTest, RenderPartOfBuffer)
         }
     }
 }
+
+TEST_F (MasterVolumeTest, GainRampsBetweenBlocks)
+{
+    masterParam.setMasterVolume (1.0);
+    masterVolume.render (&audioBuffer, 0, samplesPerBlock);
+
+    setTestInput2Constant (&audioBuffer, 1.0);
+    masterParam.setMasterVolume (0.5);
+    masterVolume.render (&audioBuffer, 0, samplesPerBlock);
+    for (int i = 0; i < audioBuffer.getNumChannels(); i++)
+    {
+        for (int j = 0; j < audioBuffer.getNumSamples(); j++)
+        {
+            const flnum expected = (1.0 - 0.5 * (j + 1) / samplesPerBlock) * gainAdjustment;
+            EXPECT_NEAR (audioBuffer.getSample (i, j), expected, 1e-6);
+        }
+    }
+    EXPECT_FLOAT_EQ (audioBuffer.getSample (0, samplesPerBlock - 1), 0.5 * gainAdjustment);
+}
+
+TEST_F (MasterVolumeTest, SoftClipMatchesTanhForSteadyInput)
+{
+    masterParam.softClipOn = true;
+    setTestInput2Constant (&audioBuffer, 10.0);
+    masterParam.setMasterVolume (1.0);
+
+    masterVolume.render (&audioBuffer, 0, samplesPerBlock);
+    const flnum input = 10.0 * gainAdjustment;
+    for (int i = 0; i < audioBuffer.getNumChannels(); i++)
+    {
+        // The first sample is interpolated from the silence before it
+        EXPECT_LT (audioBuffer.getSample (i, 0), clippingValue * std::tanh (input / clippingValue));
+        for (int j = 1; j < audioBuffer.getNumSamples(); j++)
+        {
+            EXPECT_FLOAT_EQ (audioBuffer.getSample (i, j), clippingValue * std::tanh (input / clippingValue));
+        }
+    }
+}
+
+TEST_F (MasterVolumeTest, SoftClipIsBounded)
+{
+    masterParam.softClipOn = true;
+    masterParam.setMasterVolume (1.0);
+    for (int i = 0; i < audioBuffer.getNumChannels(); i++)
+    {
+        for (int j = 0; j < audioBuffer.getNumSamples(); j++)
+        {
+            audioBuffer.setSample (i, j, 1000.0 * std::sin (j * 2.9));
+        }
+    }
+
+    masterVolume.render (&audioBuffer, 0, samplesPerBlock);
+    for (int i = 0; i < audioBuffer.getNumChannels(); i++)
+    {
+        for (int j = 0; j < audioBuffer.getNumSamples(); j++)
+        {
+            EXPECT_LE (std::abs (audioBuffer.getSample (i, j)), clippingValue);
+        }
+    }
+}
+
+// The 3rd harmonic of a high sine folds back below the Nyquist frequency
+TEST_F (MasterVolumeTest, SoftClipAliasesLessThanPlainTanh)
+{
+    masterParam.softClipOn = true;
+    masterParam.setMasterVolume (1.0);
+    constexpr int fundamentalBin = 131;
+    constexpr int aliasBin = samplesPerBlock - 3 * fundamentalBin;
+    constexpr flnum amplitude = 20.0;
+    for (int i = 0; i < audioBuffer.getNumChannels(); i++)
+    {
+        for (int j = 0; j < audioBuffer.getNumSamples(); j++)
+        {
+            audioBuffer.setSample (i, j, amplitude * std::sin (2.0 * pi * fundamentalBin * j / samplesPerBlock));
+        }
+    }
+    // Settle the state with a whole period
+    masterVolume.render (&audioBuffer, 0, samplesPerBlock);
+    for (int j = 0; j < audioBuffer.getNumSamples(); j++)
+    {
+        audioBuffer.setSample (0, j, amplitude * std::sin (2.0 * pi * fundamentalBin * j / samplesPerBlock));
+    }
+    masterVolume.render (&audioBuffer, 0, samplesPerBlock);
+
+    auto magnitudeAt = [] (int bin, auto sample) {
+        std::complex<double> sum = 0.0;
+        for (int j = 0; j < samplesPerBlock; j++)
+        {
+            sum += static_cast<double> (sample (j)) * std::polar (1.0, -2.0 * pi_v<double> * bin * j / samplesPerBlock);
+        }
+        return std::abs (sum);
+    };
+    const double aliasAdaa = magnitudeAt (aliasBin, [this] (int j) { return audioBuffer.getSample (0, j); });
+    const double aliasPlain = magnitudeAt (aliasBin, [] (int j) {
+        const double input = amplitude * gainAdjustment * std::sin (2.0 * pi_v<double> * fundamentalBin * j / samplesPerBlock);
+        return clippingValue * std::tanh (input / clippingValue);
+    });
+    EXPECT_LT (aliasAdaa, aliasPlain * 0.1);
+}
 } // namespace onsen
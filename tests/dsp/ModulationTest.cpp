@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+   Modulation Test
+
+  ==============================================================================
+*/
+
+#include "../../src/dsp/Modulation.h"
+#include <gtest/gtest.h>
+
+namespace onsen
+{
+//==============================================================================
+// ControlRateValue
+
+TEST (ControlRateValueTest, AudioRateEvaluatesEverySample)
+{
+    ControlRateValue<flnum> value;
+    int numEvaluated = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_FLOAT_EQ (value.next ([&numEvaluated] { return static_cast<flnum> (numEvaluated++); }), i);
+    }
+    EXPECT_EQ (numEvaluated, 4);
+}
+
+TEST (ControlRateValueTest, ControlRateRampsBetweenControlPoints)
+{
+    ControlRateValue<flnum> value;
+    value.setInterval (4);
+    int numEvaluated = 0;
+    flnum target = 1.0;
+    auto evaluate = [&numEvaluated, &target] {
+        ++numEvaluated;
+        return target;
+    };
+
+    // The first control point doesn't ramp
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_FLOAT_EQ (value.next (evaluate), 1.0);
+    }
+    target = 3.0;
+    EXPECT_FLOAT_EQ (value.next (evaluate), 1.5);
+    EXPECT_FLOAT_EQ (value.next (evaluate), 2.0);
+    EXPECT_FLOAT_EQ (value.next (evaluate), 2.5);
+    EXPECT_FLOAT_EQ (value.next (evaluate), 3.0);
+    EXPECT_EQ (numEvaluated, 2);
+
+    // Restarts from the next value
+    value.reset();
+    target = -1.0;
+    EXPECT_FLOAT_EQ (value.next (evaluate), -1.0);
+    EXPECT_EQ (numEvaluated, 3);
+}
+
+//==============================================================================
+// ModulationMatrix
+
+TEST (ModulationMatrixTest, ModulatesOnlyByCompiledRoutes)
+{
+    ModulationMatrix matrix;
+    const ModSourceValues<flnum> sources { 0.5, 0.25 }; // LFO, envelope
+    EXPECT_FALSE (matrix.hasRoutes (ModDestination::pitch));
+    EXPECT_FLOAT_EQ (matrix.modulate (ModDestination::pitch, sources), 0.0);
+
+    matrix.setDepth (ModSource::lfo, ModDestination::pitch, 0.4);
+    matrix.setDepth (ModSource::envelope, ModDestination::pitch, -2.0);
+    matrix.setDepth (ModSource::envelope, ModDestination::filterFreq, 1.0);
+    // Not compiled yet
+    EXPECT_FALSE (matrix.hasRoutes (ModDestination::pitch));
+
+    matrix.compile();
+    EXPECT_TRUE (matrix.hasRoutes (ModDestination::pitch));
+    EXPECT_TRUE (matrix.hasRoutes (ModDestination::filterFreq));
+    EXPECT_FALSE (matrix.hasRoutes (ModDestination::shape));
+    EXPECT_FLOAT_EQ (matrix.modulate (ModDestination::pitch, sources), 0.4 * 0.5 - 2.0 * 0.25);
+    EXPECT_FLOAT_EQ (matrix.modulate (ModDestination::filterFreq, sources), 0.25);
+    EXPECT_FLOAT_EQ (matrix.modulate (ModDestination::shape, sources), 0.0);
+
+    // Zero depth removes the route
+    matrix.setDepth (ModSource::envelope, ModDestination::filterFreq, 0.0);
+    matrix.compile();
+    EXPECT_FALSE (matrix.hasRoutes (ModDestination::filterFreq));
+    EXPECT_FLOAT_EQ (matrix.getDepth (ModSource::lfo, ModDestination::pitch), 0.4);
+}
+} // namespace onsen
@@ -8,7 +8,9 @@
 
 #include "../../src/dsp/Oscillator.h"
 #include "../../src/params/OscillatorParamsMock.h"
+#include <array>
 #include <gtest/gtest.h>
+#include <memory>
 #include <vector>
 
 namespace onsen
@@ -20,59 +22,61 @@ TEST (OscillatorTest, Sin)
 {
     // Only sin oscillator is used
     OscillatorParamsMock params { 1.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
-    Oscillator osc (&params);
-    // Note that sin's algle is twice angleRad parameter of ocillatorVal()
-    EXPECT_NEAR (osc.oscillatorVal (0.0, 0.0), 0.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 2.0) / 2.0, 0.0), 1.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi) / 2.0, 0.0), 0.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi * 3.0 / 2.0) / 2.0, 0.0), -1.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 6.0) / 2.0, 0.0), 0.5, EPSILON);
+    Oscillator<flnum> osc (&params);
+    // The error bound of DspMath::fastSin() when OS251_FAST_MATH is enabled
+    constexpr flnum SIN_EPSILON = OS251_FAST_MATH ? 3e-7 : EPSILON;
+    // Note that sin's algle is twice the phase parameter of ocillatorVal()
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians (0.0), 0.0), 0.0, SIN_EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 2.0) / 2.0), 0.0), 1.0, SIN_EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi) / 2.0), 0.0), 0.0, SIN_EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi * 3.0 / 2.0) / 2.0), 0.0), -1.0, SIN_EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 6.0) / 2.0), 0.0), 0.5, SIN_EPSILON);
 }
 
 TEST (OscillatorTest, Square)
 {
     // Only square oscillator is used
     OscillatorParamsMock params { 0.0, 1.0, 0.0, 0.0, 0.0, 0.0 };
-    Oscillator osc (&params);
-    // Note that square's algle is twice angleRad parameter of ocillatorVal()
-    EXPECT_NEAR (osc.oscillatorVal (0.0, 0.0), 1.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 2.0) / 2.0, 0.0), 1.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi) / 2.0, 0.0), -1.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi * 3.0 / 2.0) / 2.0, 0.0), -1.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 6.0) / 2.0, 0.0), 1.0, EPSILON);
+    Oscillator<flnum> osc (&params);
+    // Note that square's algle is twice the phase parameter of ocillatorVal()
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians (0.0), 0.0), 1.0, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 2.0) / 2.0), 0.0), 1.0, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi) / 2.0), 0.0), -1.0, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi * 3.0 / 2.0) / 2.0), 0.0), -1.0, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 6.0) / 2.0), 0.0), 1.0, EPSILON);
 }
 
 TEST (OscillatorTest, Saw)
 {
     // Only saw oscillator is used
     OscillatorParamsMock params { 0.0, 0.0, 1.0, 0.0, 0.0, 0.0 };
-    Oscillator osc (&params);
-    // Note that saw's algle is twice angleRad parameter of ocillatorVal()
-    EXPECT_NEAR (osc.oscillatorVal (0.0, 0.0), -1.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 2.0) / 2.0, 0.0), -0.5, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi) / 2.0, 0.0), 0.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi * 3.0 / 2.0) / 2.0, 0.0), 0.5, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 6.0) / 2.0, 0.0), -0.83333331346511841, EPSILON);
+    Oscillator<flnum> osc (&params);
+    // Note that saw's algle is twice the phase parameter of ocillatorVal()
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians (0.0), 0.0), -1.0, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 2.0) / 2.0), 0.0), -0.5, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi) / 2.0), 0.0), 0.0, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi * 3.0 / 2.0) / 2.0), 0.0), 0.5, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 6.0) / 2.0), 0.0), -0.83333331346511841, EPSILON);
 }
 
 TEST (OscillatorTest, SubSquare)
 {
     // Only sub square oscillator is used
     OscillatorParamsMock params { 0.0, 0.0, 0.0, 1.0, 0.0, 0.0 };
-    Oscillator osc (&params);
+    Oscillator<flnum> osc (&params);
 
-    EXPECT_NEAR (osc.oscillatorVal (0.0, 0.0), 1.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 2.0), 0.0), 1.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi), 0.0), -1.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi * 3.0 / 2.0), 0.0), -1.0, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 6.0), 0.0), 1.0, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians (0.0), 0.0), 1.0, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 2.0)), 0.0), 1.0, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi)), 0.0), -1.0, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi * 3.0 / 2.0)), 0.0), -1.0, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 6.0)), 0.0), 1.0, EPSILON);
 }
 
 TEST (OscillatorTest, Noise)
 {
     // Only noise oscillator is used
     OscillatorParamsMock params { 0.0, 0.0, 0.0, 0.0, 1.0, 0.0 };
-    Oscillator osc (&params);
+    Oscillator<flnum> osc (&params);
 
     int n = 1000;
     std::vector<flnum> vals;
@@ -80,7 +84,7 @@ TEST (OscillatorTest, Noise)
     // Generate value and calculate mean
     for (int i = 0; i < n; ++i)
     {
-        flnum val = osc.oscillatorVal (0.0, 0.0);
+        flnum val = osc.oscillatorVal (Phasor::fromRadians (0.0), 0.0);
         EXPECT_LE (val, 1.0);
         EXPECT_GE (val, 0.0);
         vals.push_back (val);
@@ -109,28 +113,100 @@ TEST (OscillatorTest, ChangeShapeAndMixWaves)
 {
     // Start with shape = 0
     OscillatorParamsMock params { 1.0, 1.0, 1.0, 1.0, 0.0, 0.0 };
-    Oscillator osc (&params);
+    Oscillator<flnum> osc (&params);
     constexpr int NUM_UPDATE = 5000;
     // Use lax epsilon because shape value is smoothed
     constexpr flnum LAX_EPSILON = 0.001;
 
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 6.0), 0.0), 2.1993587017059326, EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 3.0), 0.0), 2.5326919555664062, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 6.0)), 0.0), 2.1993589401245117, EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 3.0)), 0.0), 2.5326921939849854, EPSILON);
     params.shape = 0.5;
     // Wait for oscillatorVal becames stable
     for (int i = 0; i < NUM_UPDATE; i++)
     {
-        osc.oscillatorVal (0, 0.0);
+        osc.oscillatorVal (Phasor::fromRadians (0), 0.0);
     }
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 6.0), 0.0), 1.6666688919067383, LAX_EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 3.0), 0.0), 2.1997506618499756, LAX_EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 6.0)), 0.0), 1.6666688919067383, LAX_EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 3.0)), 0.0), 2.1997506618499756, LAX_EPSILON);
     params.shape = 1.0;
     // Wait for oscillatorVal becames stable
     for (int i = 0; i < NUM_UPDATE; i++)
     {
-        osc.oscillatorVal (0, 0.0);
+        osc.oscillatorVal (Phasor::fromRadians (0), 0.0);
     }
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 6.0), 0.0), 1.0000048875808716, LAX_EPSILON);
-    EXPECT_NEAR (osc.oscillatorVal ((pi / 3.0), 0.0), 1.0012624263763428, LAX_EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 6.0)), 0.0), 1.0000048875808716, LAX_EPSILON);
+    EXPECT_NEAR (osc.oscillatorVal (Phasor::fromRadians ((pi / 3.0)), 0.0), 1.0012624263763428, LAX_EPSILON);
+}
+
+TEST (OscillatorTest, SelectedKernelMatchesAllWaves)
+{
+    // Noise is left out because it's random
+    for (int mask = 0; mask < (1 << 4); ++mask)
+    {
+        for (flnum shape : { 0.0f, 0.5f })
+        {
+            OscillatorParamsMock params { mask & 1 ? 0.7f : 0.0f,
+                                          mask & 2 ? 0.5f : 0.0f,
+                                          mask & 4 ? 0.3f : 0.0f,
+                                          mask & 8 ? 0.2f : 0.0f,
+                                          0.0,
+                                          shape };
+            Oscillator<flnum> allWaves (&params);
+            Oscillator<flnum> selected (&params);
+            selected.selectKernel (false);
+
+            Phasor phase;
+            for (int i = 0; i < 200; ++i)
+            {
+                ASSERT_EQ (selected.oscillatorVal (phase, 0.0), allWaves.oscillatorVal (phase, 0.0))
+                    << "mask " << mask << ", shape " << shape << ", sample " << i;
+                phase.advance (Phasor::toIncrement (0.013));
+            }
+        }
+    }
+}
+
+TEST (OscillatorTest, LanesMatchSingleLane)
+{
+    OscillatorParamsMock params { 0.7, 0.5, 0.3, 0.2, 0.0, 0.4 };
+    Oscillator<flnum> lanes (&params);
+    std::vector<std::unique_ptr<Oscillator<flnum>>> singles;
+    constexpr int numLanes = Oscillator<flnum>::maxNumLanes;
+    std::array<Phasor, numLanes> phases;
+    for (int i = 0; i < numLanes; ++i)
+    {
+        singles.push_back (std::make_unique<Oscillator<flnum>> (&params));
+        phases[i] = Phasor::fromCycles (i * 0.1);
+    }
+
+    for (int n = 0; n < 100; ++n)
+    {
+        std::array<flnum, numLanes> vals;
+        lanes.oscillatorVals (phases.data(), vals.data(), numLanes, 0.1);
+        for (int i = 0; i < numLanes; ++i)
+        {
+            // The fast sin of 4 lanes at once can differ by its error bound
+            EXPECT_NEAR (vals[i], singles[i]->oscillatorVal (phases[i], 0.1), OS251_FAST_MATH ? 1e-6 : 0.0);
+            phases[i].advance (Phasor::toIncrement (0.01 * (i + 1)));
+        }
+    }
+}
+
+TEST (OscillatorTest, SelectedKernelKeepsShapeUntilItSettles)
+{
+    OscillatorParamsMock params { 0.0, 0.0, 1.0, 0.0, 0.0, 1.0 };
+    Oscillator<flnum> allWaves (&params);
+    Oscillator<flnum> selected (&params);
+    const Phasor phase = Phasor::fromRadians (pi / 6.0);
+    allWaves.oscillatorVal (phase, 0.0);
+    selected.oscillatorVal (phase, 0.0);
+
+    // The smoothed shape is still moving towards 0
+    params.shape = 0.0;
+    selected.selectKernel (false);
+    EXPECT_EQ (selected.oscillatorVal (phase, 0.0), allWaves.oscillatorVal (phase, 0.0));
+    // Shape modulation needs the shaped kernel even if the shape is 0
+    selected.selectKernel (true);
+    EXPECT_EQ (selected.oscillatorVal (phase, 0.25), allWaves.oscillatorVal (phase, 0.25));
 }
 } // namespace onsen
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+   Oversampler Test
+
+  ==============================================================================
+*/
+
+#include "../../src/dsp/Oversampler.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace onsen
+{
+//==============================================================================
+// Oversampler
+
+class OversamplerTest : public ::testing::Test
+{
+protected:
+    static constexpr int numChannels = 2;
+    static constexpr int samplesPerBlock = 512;
+    static constexpr int numBlocks = 8;
+
+    // Decimate a sine wave at `freqRatio` of the oversampled rate in every
+    // channel and return the amplitude of the output after the filters are
+    // settled.
+    static double decimatedAmplitude (int factor, double freqRatio)
+    {
+        Oversampler<flnum> oversampler (numChannels);
+        oversampler.setFactor (factor);
+
+        std::vector<std::vector<flnum>> data (numChannels, std::vector<flnum> (samplesPerBlock * factor));
+        double sumOfSquares = 0.0;
+        int phase = 0;
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int i = 0; i < samplesPerBlock * factor; ++i)
+            {
+                const flnum val = std::sin (2.0 * pi_v<double> * freqRatio * phase++);
+                for (auto& channel : data)
+                {
+                    channel[i] = val;
+                }
+            }
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                oversampler.decimate (channel, data[channel].data(), samplesPerBlock);
+            }
+
+            // Every channel should have same value.
+            for (int i = 0; i < samplesPerBlock; ++i)
+            {
+                EXPECT_FLOAT_EQ (data[0][i], data[1][i]);
+            }
+            if (block == 0)
+            {
+                continue;
+            }
+            for (int i = 0; i < samplesPerBlock; ++i)
+            {
+                sumOfSquares += data[0][i] * data[0][i];
+            }
+        }
+        // RMS of a sine wave is amplitude / sqrt (2)
+        return std::sqrt (2.0 * sumOfSquares / ((numBlocks - 1) * samplesPerBlock));
+    }
+};
+
+TEST_F (OversamplerTest, PassesAudibleBand)
+{
+    for (const int factor : { 2, 4 })
+    {
+        // 0.2 of the sample rate after decimation
+        EXPECT_NEAR (decimatedAmplitude (factor, 0.2 / factor), 1.0, 1e-3);
+        EXPECT_NEAR (decimatedAmplitude (factor, 0.01 / factor), 1.0, 1e-3);
+    }
+}
+
+TEST_F (OversamplerTest, RejectsImages)
+{
+    // They fold back into the audible band without the filters.
+    EXPECT_LT (decimatedAmplitude (2, 0.31), 1e-4);
+    EXPECT_LT (decimatedAmplitude (2, 0.45), 1e-4);
+    EXPECT_LT (decimatedAmplitude (4, 0.155), 1e-4);
+    EXPECT_LT (decimatedAmplitude (4, 0.3), 1e-3);
+}
+
+TEST_F (OversamplerTest, WritesOnlyFirstSamples)
+{
+    Oversampler<flnum> oversampler;
+    oversampler.setFactor (2);
+
+    // DC passes once the filters are settled, and the rest of the
+    // oversampled samples are left as they are
+    std::vector<flnum> data (samplesPerBlock * 2, 0.25);
+    oversampler.decimate (0, data.data(), samplesPerBlock);
+    EXPECT_NEAR (data[100], 0.25, 1e-4);
+    EXPECT_NEAR (data[samplesPerBlock - 1], 0.25, 1e-4);
+    EXPECT_EQ (data[samplesPerBlock], 0.25f);
+    EXPECT_EQ (data[samplesPerBlock * 2 - 1], 0.25f);
+}
+
+TEST_F (OversamplerTest, DecimatesChannelsIndependently)
+{
+    for (const int factor : { 2, 4 })
+    {
+        // Only the left channel goes through the reference
+        Oversampler<flnum> reference;
+        reference.setFactor (factor);
+        Oversampler<flnum> oversampler (numChannels);
+        oversampler.setFactor (factor);
+
+        std::vector<flnum> mono (samplesPerBlock * factor);
+        std::vector<flnum> left (samplesPerBlock * factor);
+        std::vector<flnum> right (samplesPerBlock * factor);
+        int phase = 0;
+        for (int block = 0; block < 2; ++block)
+        {
+            for (int i = 0; i < samplesPerBlock * factor; ++i)
+            {
+                const flnum val = std::sin (0.01 * phase++);
+                mono[i] = val;
+                left[i] = val;
+                // The other channel's state shouldn't leak into the left one
+                right[i] = 1.0;
+            }
+            reference.decimate (0, mono.data(), samplesPerBlock);
+            oversampler.decimate (0, left.data(), samplesPerBlock);
+            oversampler.decimate (1, right.data(), samplesPerBlock);
+            for (int i = 0; i < samplesPerBlock; ++i)
+            {
+                EXPECT_EQ (left[i], mono[i]);
+            }
+        }
+    }
+}
+
+TEST_F (OversamplerTest, LatencyIsGroupDelay)
+{
+    EXPECT_EQ (Oversampler<double>::getLatency (1), 0.0);
+    for (const int factor : { 2, 4 })
+    {
+        Oversampler<double> oversampler;
+        oversampler.setFactor (factor);
+        // A slow sine at the output rate comes out delayed by the latency
+        const double omega = 0.01;
+        std::vector<double> data (samplesPerBlock * factor);
+        for (int i = 0; i < samplesPerBlock * factor; ++i)
+        {
+            data[i] = std::sin (omega * i / factor);
+        }
+        oversampler.decimate (0, data.data(), samplesPerBlock);
+        const double latency = Oversampler<double>::getLatency (factor);
+        for (int i = 100; i < samplesPerBlock; ++i)
+        {
+            EXPECT_NEAR (data[i], std::sin (omega * (i - latency)), 1e-3);
+        }
+    }
+}
+} // namespace onsen
@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+   Phasor Test
+
+  ==============================================================================
+*/
+
+#include "../../src/dsp/Phasor.h"
+#include <gtest/gtest.h>
+
+namespace onsen
+{
+//==============================================================================
+// Phasor
+
+TEST (PhasorTest, WrapsAround)
+{
+    Phasor phasor = Phasor::fromCycles (0.75);
+    const Phasor::Phase increment = Phasor::toIncrement (0.125);
+    phasor.advance (increment);
+    EXPECT_DOUBLE_EQ (phasor.normalized<double>(), 0.875);
+    phasor.advance (increment);
+    EXPECT_DOUBLE_EQ (phasor.normalized<double>(), 0.0);
+    phasor.advance (increment);
+    EXPECT_DOUBLE_EQ (phasor.normalized<double>(), 0.125);
+
+    // Backwards
+    phasor.advance (Phasor::toIncrement (-0.25));
+    EXPECT_DOUBLE_EQ (phasor.normalized<double>(), 0.875);
+    EXPECT_DOUBLE_EQ (Phasor::fromCycles (-0.25).normalized<double>(), 0.75);
+    EXPECT_DOUBLE_EQ (Phasor::fromCycles (3.25).normalized<double>(), 0.25);
+}
+
+TEST (PhasorTest, DoesntDriftOverLongNotes)
+{
+    // 10 minutes of 20.6 Hz at 44.1 kHz
+    constexpr int numSamples = 44100 * 600;
+    const double cyclesPerSample = 20.6 / 44100.0;
+    const Phasor::Phase increment = Phasor::toIncrement (cyclesPerSample);
+    // The frequency is rounded to 44.1 kHz / 2^32 (about 1e-5 Hz)
+    EXPECT_NEAR (increment / Phasor::phasesPerCycle, cyclesPerSample, 0.5 / Phasor::phasesPerCycle);
+
+    Phasor phasor;
+    for (int i = 0; i < numSamples; ++i)
+        phasor.advance (increment);
+
+    // No rounding error is accumulated
+    EXPECT_EQ (phasor.get(), static_cast<Phasor::Phase> (static_cast<std::uint64_t> (increment) * numSamples));
+}
+
+TEST (PhasorTest, NormalizedFloatIsBelowOne)
+{
+    const Phasor phasor (0xffffffffu);
+    EXPECT_LT (phasor.normalized<float>(), 1.0f);
+    EXPECT_LT (phasor.radians<float>(), DspMath::twoPi<float>);
+}
+
+TEST (PhasorTest, IndexesTable)
+{
+    const Phasor phasor = Phasor::fromCycles (0.3);
+    // 0.3 * 256 = 76.8
+    EXPECT_EQ (phasor.index<8>(), 76);
+    EXPECT_NEAR ((phasor.fraction<8, double>()), 0.8, 1e-6);
+    EXPECT_TRUE (phasor.isFirstHalf());
+    EXPECT_FALSE (phasor.doubled().isFirstHalf());
+    EXPECT_NEAR (phasor.doubled().normalized<double>(), 0.6, 1e-9);
+}
+
+TEST (PhasorTest, RadiansBetween)
+{
+    const Phasor a = Phasor::fromCycles (0.95);
+    const Phasor b = Phasor::fromCycles (0.05);
+    EXPECT_NEAR (Phasor::radiansBetween (a, b), 0.1 * DspMath::twoPi<double>, 1e-9);
+    EXPECT_NEAR (Phasor::radiansBetween (b, a), -0.1 * DspMath::twoPi<double>, 1e-9);
+}
+} // namespace onsen
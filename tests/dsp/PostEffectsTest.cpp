@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+   Post effects test
+
+  ==============================================================================
+*/
+
+#include "../../src/dsp/PostEffects.h"
+#include "../../src/params/ChorusParamsMock.h"
+#include "../../src/params/HpfParamsMock.h"
+#include "../../src/params/MasterParamsMock.h"
+#include "util/AudioBufferMock.h"
+#include "util/TestAudioBufferInput.h"
+#include <gtest/gtest.h>
+
+namespace onsen
+{
+//==============================================================================
+// Post effects
+
+class PostEffectsTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        fused.setCurrentPlaybackSampleRate (sampleRate);
+        hpf.setCurrentPlaybackSampleRate (sampleRate);
+        chorus.setCurrentPlaybackSampleRate (sampleRate);
+    }
+
+    // The chain without the fusion, which runs each effect over the whole block
+    void renderSeparately (IAudioBuffer<flnum>* outputAudio, int startSample, int numSamples)
+    {
+        hpf.render (outputAudio, startSample, numSamples);
+        if (chorusParam.getChorusOn())
+            chorus.render (outputAudio, startSample, numSamples);
+        masterVolume.render (outputAudio, startSample, numSamples);
+    }
+
+    // Render blocks of `blockSizes` with both paths and compare them
+    void expectFusedMatchesSeparate (const std::vector<int>& blockSizes)
+    {
+        for (size_t block = 0; block < blockSizes.size(); ++block)
+        {
+            // Change the gain every block to ramp it
+            masterParam.setMasterVolume (block % 2 == 0 ? 1.0 : 0.3);
+            AudioBufferMock<flnum> fusedBuffer { numChannels, samplesPerBlock };
+            AudioBufferMock<flnum> separateBuffer { numChannels, samplesPerBlock };
+            setTestInput1 (&fusedBuffer);
+            setTestInput1 (&separateBuffer);
+
+            // Not aligned to the sub-blocks
+            const int startSample = 3;
+            fused.render (&fusedBuffer, startSample, blockSizes[block]);
+            // The fused chain clips the block at the end of the buffer
+            renderSeparately (&separateBuffer, startSample, std::min (blockSizes[block], samplesPerBlock - startSample));
+            for (int i = 0; i < numChannels; ++i)
+            {
+                for (int j = 0; j < samplesPerBlock; ++j)
+                {
+                    ASSERT_EQ (fusedBuffer.getSample (i, j), separateBuffer.getSample (i, j))
+                        << "block " << block << " channel " << i << " sample " << j;
+                }
+            }
+        }
+    }
+
+    static constexpr double sampleRate = 44100;
+    static constexpr int samplesPerBlock = 512;
+    static constexpr int numChannels = 2;
+    HpfParamsMock hpfParam;
+    ChorusParamsMock chorusParam;
+    MasterParamsMock masterParam { false, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+    PostEffects<flnum> fused { &hpfParam, &chorusParam, &masterParam, numChannels };
+    Hpf<flnum> hpf { &hpfParam, numChannels };
+    Chorus<flnum> chorus;
+    MasterVolume<flnum> masterVolume { &masterParam, numChannels };
+};
+
+TEST_F (PostEffectsTest, FusedMatchesSeparateWithChorus)
+{
+    chorusParam.chorusOn = true;
+    expectFusedMatchesSeparate ({ 500, 128, 37, 200 });
+}
+
+TEST_F (PostEffectsTest, FusedMatchesSeparateWithoutChorus)
+{
+    chorusParam.chorusOn = false;
+    expectFusedMatchesSeparate ({ 500, 128, 37, 200 });
+}
+
+TEST_F (PostEffectsTest, FusedMatchesSeparateWithSoftClip)
+{
+    masterParam.softClipOn = true;
+    expectFusedMatchesSeparate ({ 500, 128, 37, 200 });
+    chorusParam.chorusOn = false;
+    expectFusedMatchesSeparate ({ 64, 1, 300 });
+}
+TEST_F (PostEffectsTest, FusedMatchesSeparateInSharedArena)
+{
+    BufferArena arena;
+    fused.useBufferArena (arena);
+    arena.allocate ([this] (BufferArena::Placer& placer) { fused.placeBuffers (placer); });
+    chorusParam.chorusOn = true;
+    expectFusedMatchesSeparate ({ 500, 128, 37, 200 });
+}
+
+TEST_F (PostEffectsTest, OversizedBlockIsClippedToBuffer)
+{
+    masterParam.softClipOn = true;
+    expectFusedMatchesSeparate ({ 600, 128, samplesPerBlock });
+}
+} // namespace onsen
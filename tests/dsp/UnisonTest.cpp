@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+   Unison Test
+
+  ==============================================================================
+*/
+
+#include "../../src/dsp/Unison.h"
+#include <array>
+#include <gtest/gtest.h>
+
+namespace onsen
+{
+//==============================================================================
+// Unison
+
+TEST (UnisonTest, SingleVoiceIsTheNote)
+{
+    Unison<flnum> unison;
+    Phasor phasor = unison.getPhases()[0];
+    const double angleDelta = 0.0123;
+    for (int i = 0; i < 1000; ++i)
+    {
+        unison.advance (angleDelta);
+        phasor.advance (Phasor::radiansToIncrement (angleDelta));
+    }
+    EXPECT_EQ (unison.getPhases()[0].get(), phasor.get());
+
+    const flnum val = 0.42f;
+    EXPECT_EQ (unison.mixMono (&val), val);
+    EXPECT_FALSE (unison.isStereo());
+}
+
+TEST (UnisonTest, DetunesSymmetrically)
+{
+    constexpr int numVoices = 5;
+    Unison<flnum> unison;
+    unison.set (numVoices, 1.0, 0.0);
+    std::array<Phasor, numVoices> start;
+    std::copy (unison.getPhases(), unison.getPhases() + numVoices, start.begin());
+
+    const double cyclesPerSample = 0.001;
+    unison.advance (cyclesPerSample * DspMath::twoPi<double>);
+    std::array<double, numVoices> cycles;
+    for (int i = 0; i < numVoices; ++i)
+    {
+        cycles[i] = static_cast<Phasor::Phase> (unison.getPhases()[i].get() - start[i].get()) / Phasor::phasesPerCycle;
+    }
+
+    // The center copy is the note and the outermost ones are maxDetuneCents away
+    constexpr double tolerance = 1e-9;
+    EXPECT_NEAR (cycles[numVoices / 2], cyclesPerSample, tolerance);
+    EXPECT_NEAR (cycles[0], cyclesPerSample * std::exp2 (-Unison<flnum>::maxDetuneCents / 1200.0), tolerance);
+    EXPECT_NEAR (cycles[numVoices - 1], cyclesPerSample * std::exp2 (Unison<flnum>::maxDetuneCents / 1200.0), tolerance);
+    for (int i = 0; i < numVoices / 2; ++i)
+    {
+        EXPECT_NEAR (cycles[i] * cycles[numVoices - 1 - i], cyclesPerSample * cyclesPerSample, tolerance);
+    }
+}
+
+TEST (UnisonTest, SpreadsOverStereo)
+{
+    constexpr int numVoices = 4;
+    Unison<flnum> unison;
+    const std::array<flnum, numVoices> vals { 1.0, 1.0, 1.0, 1.0 };
+
+    // No spread is the mono mix in both channels
+    unison.set (numVoices, 0.5, 0.0);
+    EXPECT_FALSE (unison.isStereo());
+    flnum left, right;
+    unison.mixStereo (vals.data(), left, right);
+    EXPECT_FLOAT_EQ (left, unison.mixMono (vals.data()));
+    EXPECT_FLOAT_EQ (right, unison.mixMono (vals.data()));
+    // The power of the uncorrelated copies is same as a single voice
+    EXPECT_FLOAT_EQ (unison.mixMono (vals.data()), 2.0);
+
+    // Full spread puts the lowest copy on the left and the highest on the right
+    unison.set (numVoices, 0.5, 1.0);
+    EXPECT_TRUE (unison.isStereo());
+    const std::array<flnum, numVoices> lowest { 1.0, 0.0, 0.0, 0.0 };
+    unison.mixStereo (lowest.data(), left, right);
+    EXPECT_NEAR (right, 0.0, 1e-7);
+    const std::array<flnum, numVoices> highest { 0.0, 0.0, 0.0, 1.0 };
+    unison.mixStereo (highest.data(), left, right);
+    EXPECT_NEAR (left, 0.0, 1e-7);
+    EXPECT_FLOAT_EQ (right, std::sqrt (2.0f) / 2.0f);
+}
+} // namespace onsen
@@ -15,7 +15,8 @@
 namespace onsen
 {
 //==============================================================================
-class AudioBufferMock : public IAudioBuffer
+template <typename SampleType = flnum>
+class AudioBufferMock : public IAudioBuffer<SampleType>
 {
 public:
     AudioBufferMock (
@@ -43,19 +44,19 @@ public:
         return audioBuffer[0].size();
     }
 
-    flnum* getWritePointer (int channel) noexcept override
+    SampleType* getWritePointer (int channel) noexcept override
     {
         assert (channel < getNumChannels() && getNumSamples() > 0);
         return &audioBuffer[channel][0];
     }
 
-    flnum getSample (int channel, int sampleIndex) const noexcept override
+    SampleType getSample (int channel, int sampleIndex) const noexcept override
     {
         assert (channel < getNumChannels() && sampleIndex < getNumSamples());
         return audioBuffer[channel][sampleIndex];
     }
 
-    void setSample (int destChannel, int destSample, flnum newValue) noexcept override
+    void setSample (int destChannel, int destSample, SampleType newValue) noexcept override
     {
         assert (destChannel < getNumChannels() && destSample < getNumSamples());
         audioBuffer[destChannel][destSample] = newValue;
@@ -64,6 +65,6 @@ public:
 private:
     static constexpr size_t DEFAULT_BUFFER_SIZE = 512;
     static constexpr size_t DEFAULT_NUM_CHANNELS = 2;
-    std::vector<std::vector<flnum>> audioBuffer;
+    std::vector<std::vector<SampleType>> audioBuffer;
 };
 } // namespace onsen
@@ -10,22 +10,24 @@
 
 namespace onsen
 {
-void setTestInput1 (IAudioBuffer* audioBuffer)
+template <typename SampleType>
+void setTestInput1 (IAudioBuffer<SampleType>* audioBuffer)
 {
     for (int i = 0; i < audioBuffer->getNumChannels(); i++)
     {
         for (int j = 0; j < audioBuffer->getNumSamples(); j++)
         {
             // Some random input
-            flnum val = static_cast<flnum> ((j * 8) % audioBuffer->getNumSamples())
-                        / static_cast<flnum> (audioBuffer->getNumSamples());
+            SampleType val = static_cast<SampleType> ((j * 8) % audioBuffer->getNumSamples())
+                             / static_cast<SampleType> (audioBuffer->getNumSamples());
             audioBuffer->setSample (i, j, val);
         }
     }
 }
 
 // Set all value to val
-void setTestInput2Constant (IAudioBuffer* audioBuffer, flnum val)
+template <typename SampleType>
+void setTestInput2Constant (IAudioBuffer<SampleType>* audioBuffer, flnum val)
 {
     for (int i = 0; i < audioBuffer->getNumChannels(); i++)
     {
@@ -35,4 +37,9 @@ void setTestInput2Constant (IAudioBuffer* audioBuffer, flnum val)
         }
     }
 }
+
+template void setTestInput1<float> (IAudioBuffer<float>*);
+template void setTestInput1<double> (IAudioBuffer<double>*);
+template void setTestInput2Constant<float> (IAudioBuffer<float>*, flnum);
+template void setTestInput2Constant<double> (IAudioBuffer<double>*, flnum);
 } // namespace onsen
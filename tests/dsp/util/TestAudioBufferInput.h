@@ -11,6 +11,8 @@
 
 namespace onsen
 {
-void setTestInput1 (IAudioBuffer* audioBuffer);
-void setTestInput2Constant (IAudioBuffer* audioBuffer, flnum val);
+template <typename SampleType>
+void setTestInput1 (IAudioBuffer<SampleType>* audioBuffer);
+template <typename SampleType>
+void setTestInput2Constant (IAudioBuffer<SampleType>* audioBuffer, flnum val);
 } // namespace onsen
@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+   Binary State Test
+  ==============================================================================
+*/
+
+#include "../../src/services/BinaryState.h"
+#include <gtest/gtest.h>
+
+namespace onsen
+{
+//==============================================================================
+TEST (BinaryStateTest, HashParameterId)
+{
+    // Known values of 32-bit FNV-1a
+    EXPECT_EQ (BinaryState::hashParameterId (""), 0x811c9dc5u);
+    EXPECT_EQ (BinaryState::hashParameterId ("a"), 0xe40c292cu);
+    EXPECT_NE (BinaryState::hashParameterId ("sinGain"), BinaryState::hashParameterId ("sawGain"));
+}
+
+TEST (BinaryStateTest, RoundTrip)
+{
+    BinaryState::State state;
+    state.params = { { BinaryState::hashParameterId ("sinGain"), 0.25f },
+                     { BinaryState::hashParameterId ("sawGain"), 1.0f },
+                     { BinaryState::hashParameterId ("frequency"), 0.123456789f } };
+    state.presetPath = "Factory/Bass/Fat Bass.oapreset";
+
+    std::vector<uint8_t> bytes;
+    BinaryState::write (state, bytes);
+    EXPECT_EQ (bytes.size(), BinaryState::headerSize + 3 * 8 + 2 + state.presetPath.size());
+    EXPECT_TRUE (BinaryState::isBinaryState (bytes.data(), bytes.size()));
+
+    BinaryState::State restored;
+    ASSERT_TRUE (BinaryState::read (bytes.data(), bytes.size(), restored));
+    EXPECT_EQ (restored.params, state.params);
+    EXPECT_EQ (restored.presetPath, state.presetPath);
+}
+
+TEST (BinaryStateTest, RejectsOtherData)
+{
+    // JUCE's copyXmlToBinary() starts with a different magic number
+    const std::string xml = "VC2!\x10\x00\x00\x00<OS-251/>";
+    EXPECT_FALSE (BinaryState::isBinaryState (xml.data(), xml.size()));
+
+    BinaryState::State state;
+    state.params = { { 1, 0.5f } };
+    std::vector<uint8_t> bytes;
+    BinaryState::write (state, bytes);
+
+    BinaryState::State restored;
+    // Truncated
+    EXPECT_FALSE (BinaryState::read (bytes.data(), bytes.size() - 1, restored));
+    EXPECT_FALSE (BinaryState::read (bytes.data(), 3, restored));
+    // Newer version
+    bytes[4] = BinaryState::version + 1;
+    EXPECT_FALSE (BinaryState::read (bytes.data(), bytes.size(), restored));
+}
+} // namespace onsen
@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+   CPU Load Meter Test
+  ==============================================================================
+*/
+
+#include "../../src/services/CpuLoadMeter.h"
+#include "../../src/services/SpscRingBuffer.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace onsen
+{
+//==============================================================================
+// SpscRingBuffer
+TEST (SpscRingBufferTest, PushAndPopInOrder)
+{
+    SpscRingBuffer<int, 4> buffer;
+    int item = 0;
+    EXPECT_FALSE (buffer.pop (item));
+
+    // Go around the buffer several times
+    for (int i = 0; i < 10; ++i)
+    {
+        EXPECT_TRUE (buffer.push (i));
+        EXPECT_TRUE (buffer.push (i + 100));
+        EXPECT_EQ (buffer.size(), 2);
+        EXPECT_TRUE (buffer.pop (item));
+        EXPECT_EQ (item, i);
+        EXPECT_TRUE (buffer.pop (item));
+        EXPECT_EQ (item, i + 100);
+        EXPECT_FALSE (buffer.pop (item));
+    }
+}
+
+TEST (SpscRingBufferTest, RejectsWhenFull)
+{
+    SpscRingBuffer<int, 4> buffer;
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE (buffer.push (i));
+    }
+    EXPECT_FALSE (buffer.push (4));
+
+    int item = 0;
+    EXPECT_TRUE (buffer.pop (item));
+    EXPECT_EQ (item, 0);
+    EXPECT_TRUE (buffer.push (4));
+}
+
+TEST (SpscRingBufferTest, TwoThreads)
+{
+    constexpr int numItems = 10000;
+    SpscRingBuffer<int, 64> buffer;
+
+    std::thread producer ([&buffer]() {
+        for (int i = 0; i < numItems;)
+        {
+            if (buffer.push (i))
+                ++i;
+            else
+                std::this_thread::yield();
+        }
+    });
+
+    std::vector<int> items;
+    items.reserve (numItems);
+    int item = 0;
+    while (static_cast<int> (items.size()) < numItems)
+    {
+        if (buffer.pop (item))
+            items.push_back (item);
+        else
+            std::this_thread::yield();
+    }
+    producer.join();
+
+    for (int i = 0; i < numItems; ++i)
+    {
+        ASSERT_EQ (items[i], i);
+    }
+}
+
+//==============================================================================
+// CpuLoadMeter
+TEST (CpuLoadMeterTest, RecordsCallback)
+{
+    CpuLoadMeter meter;
+    meter.prepareToPlay (48000.0);
+
+    // A callback taking the whole budget of 480 samples (10 ms)
+    const auto startTime = meter.start() - std::chrono::milliseconds (10);
+    meter.stop (startTime, 480, 3);
+
+    std::vector<CpuLoadRecord> records;
+    EXPECT_EQ (meter.readRecords ([&records] (const CpuLoadRecord& record) { records.push_back (record); }), 1);
+    ASSERT_EQ (records.size(), 1);
+    EXPECT_GE (records[0].durationSec, 0.010);
+    EXPECT_GE (records[0].load, 1.0);
+    EXPECT_EQ (records[0].numSamples, 480);
+    EXPECT_EQ (records[0].numActiveVoices, 3);
+    EXPECT_TRUE (records[0].xrunRisk);
+
+    // Already read
+    EXPECT_EQ (meter.readRecords ([] (const CpuLoadRecord&) {}), 0);
+}
+
+TEST (CpuLoadMeterTest, LightCallbackHasNoXrunRisk)
+{
+    CpuLoadMeter meter;
+    meter.prepareToPlay (48000.0);
+
+    // The budget of 48000 samples is 1 sec
+    meter.stop (meter.start(), 48000, 0);
+
+    meter.readRecords ([] (const CpuLoadRecord& record) {
+        EXPECT_LT (record.load, CpuLoadMeter::xrunRiskLoad);
+        EXPECT_FALSE (record.xrunRisk);
+    });
+}
+
+TEST (CpuLoadMeterTest, CountsDroppedRecords)
+{
+    CpuLoadMeter meter;
+    for (size_t i = 0; i < CpuLoadMeter::capacity + 5; ++i)
+    {
+        meter.stop (meter.start(), 512, 0);
+    }
+    EXPECT_EQ (meter.getNumDroppedRecords(), 5);
+    EXPECT_EQ (meter.readRecords ([] (const CpuLoadRecord&) {}), CpuLoadMeter::capacity);
+}
+} // namespace onsen
@@ -30,6 +30,14 @@ protected:
         testDir.deleteRecursively();
     }
 
+    // Waits for the preset watcher thread
+    static bool waitUntil (std::function<bool()> condition)
+    {
+        for (int i = 0; i < 100 && ! condition(); ++i)
+            juce::Thread::sleep (50);
+        return condition();
+    }
+
     const juce::File testDir { onsen::TmpFileManager::getTmpDir().getChildFile ("preset_test") };
     const juce::File testPresetDir { testDir.getChildFile ("presets") };
     AudioProcessorStateMock processorState;
@@ -72,6 +80,19 @@ TEST_F (PresetManagerTest, LoadDefaultPreset)
     EXPECT_EQ (stateXml->getChildByAttribute ("id", "masterVolume")->getAttributeValue (1), "0.5");
 }
 
+TEST_F (PresetManagerTest, LoadEmbeddedDefaultPreset)
+{
+    presetManager.loadEmbeddedDefaultPreset();
+    // The preset folder isn't touched
+    EXPECT_FALSE (testPresetDir.exists());
+    auto stateXml = processorState.copyState().createXml();
+    EXPECT_TRUE (stateXml->hasTagName ("OS-251"));
+    EXPECT_EQ (stateXml->getChildByAttribute ("id", "subSquareGain")->getAttributeValue (1 /*value*/), "1.0");
+    EXPECT_EQ (stateXml->getChildByAttribute ("id", "resonance")->getAttributeValue (1), "0.3499999940395355");
+    EXPECT_EQ (stateXml->getChildByAttribute ("id", "masterVolume")->getAttributeValue (1), "0.5");
+    EXPECT_EQ (processorState.getPreset(), juce::String ("Default.oapreset"));
+}
+
 TEST_F (PresetManagerTest, LoadPreset)
 {
     presetManager.scanPresets();
@@ -394,4 +415,101 @@ TEST_F (PresetManagerTest, RescanPresetAfterDeletingPresetDir)
     EXPECT_EQ (presetManager.getPresets().size(), numPresets);
 }
 
+TEST_F (PresetManagerTest, SavePresetIndex)
+{
+    presetManager.scanPresets();
+    auto indexFile = testPresetDir.getChildFile (".preset_index");
+    EXPECT_TRUE (indexFile.existsAsFile());
+
+    // Loading from the index restores the same state as parsing the preset
+    auto bass0 = presetManager.getFactoryPresetDir().getChildFile ("Bass/Bass0.oapreset");
+    presetManager.loadPreset (bass0);
+    auto indexedStateXml = processorState.copyState().createXml();
+
+    juce::XmlDocument xmlDocument (bass0);
+    std::unique_ptr<juce::XmlElement> presetXml (xmlDocument.getDocumentElement());
+    auto* stateXml = presetXml->getChildByName ("State")->getChildByName ("OS-251");
+    for (auto* paramXml = stateXml->getFirstChildElement(); paramXml != nullptr; paramXml = paramXml->getNextElement())
+    {
+        auto id = paramXml->getStringAttribute ("id");
+        EXPECT_EQ (static_cast<float> (indexedStateXml->getChildByAttribute ("id", id)->getDoubleAttribute ("value")),
+                   static_cast<float> (paramXml->getDoubleAttribute ("value")))
+            << id;
+    }
+
+    // Another instance reads the index
+    AudioProcessorStateMock otherProcessorState;
+    PresetManager otherPresetManager { &otherProcessorState, testPresetDir };
+    otherPresetManager.scanPresets();
+    EXPECT_EQ (otherPresetManager.getPresets(), presetManager.getPresets());
+    otherPresetManager.loadPreset (bass0);
+    EXPECT_EQ (otherPresetManager.getCurrentPresetFile(), bass0);
+}
+
+TEST_F (PresetManagerTest, ModifiedPresetIsReindexed)
+{
+    presetManager.scanPresets();
+    auto bass0 = presetManager.getFactoryPresetDir().getChildFile ("Bass/Bass0.oapreset");
+    bass0.replaceWithText ("Broken Preset XML");
+
+    // The index must not be used for the modified preset
+    presetManager.loadPreset (bass0);
+    EXPECT_EQ (presetManager.getCurrentPresetFile(), presetManager.getDefaultPresetFile());
+
+    presetManager.scanPresets();
+    presetManager.loadPreset (bass0);
+    EXPECT_EQ (presetManager.getCurrentPresetFile(), presetManager.getDefaultPresetFile());
+}
+
+TEST_F (PresetManagerTest, ScanPresetsAsyncAndWatchPresetFolder)
+{
+    presetManager.scanPresets();
+    const auto presets = presetManager.getPresets();
+    const auto newPreset = presetManager.getUserPresetDir().getChildFile ("New.oapreset");
+
+    // Scoped to stop watching before TearDown() deletes the preset folder
+    {
+        PresetManager watchingPresetManager { &processorState, testPresetDir };
+        watchingPresetManager.scanPresetsAsync();
+        EXPECT_TRUE (waitUntil ([&]() { return watchingPresetManager.getPresets() == presets; }));
+
+        presetManager.getFactoryPresetDir().getChildFile ("Bass/Bass0.oapreset").copyFileTo (newPreset);
+        EXPECT_TRUE (waitUntil ([&]() { return watchingPresetManager.getPresets().contains (newPreset); }));
+        EXPECT_EQ (watchingPresetManager.getPresets().size(), presets.size() + 1);
+        EXPECT_EQ (watchingPresetManager.getPresetList()->presetIdxByPath.count (newPreset.getFullPathName()), 1u);
+
+        newPreset.deleteFile();
+        EXPECT_TRUE (waitUntil ([&]() { return watchingPresetManager.getPresets() == presets; }));
+    }
+}
+
+TEST_F (PresetManagerTest, ManagersOfSameFolderShareWatcher)
+{
+    presetManager.scanPresets();
+    const auto presets = presetManager.getPresets();
+    const auto newPreset = presetManager.getUserPresetDir().getChildFile ("New.oapreset");
+
+    // Scoped to stop watching before TearDown() deletes the preset folder
+    {
+        PresetManager firstPresetManager { &processorState, testPresetDir };
+        PresetManager secondPresetManager { &processorState, testPresetDir };
+        firstPresetManager.scanPresetsAsync();
+        secondPresetManager.scanPresetsAsync();
+        EXPECT_TRUE (waitUntil ([&]() { return secondPresetManager.getPresets() == presets; }));
+
+        // A manager which comes and goes doesn't stop the shared watcher
+        {
+            PresetManager thirdPresetManager { &processorState, testPresetDir };
+            thirdPresetManager.scanPresetsAsync();
+        }
+        presetManager.getFactoryPresetDir().getChildFile ("Bass/Bass0.oapreset").copyFileTo (newPreset);
+        EXPECT_TRUE (waitUntil ([&]() { return firstPresetManager.getPresets().contains (newPreset)
+                                               && secondPresetManager.getPresets().contains (newPreset); }));
+
+        newPreset.deleteFile();
+        EXPECT_TRUE (waitUntil ([&]() { return firstPresetManager.getPresets() == presets
+                                               && secondPresetManager.getPresets() == presets; }));
+    }
+}
+
 } // namespace onsen
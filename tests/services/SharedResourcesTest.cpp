@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+   Shared Resources Test
+  ==============================================================================
+*/
+
+#include "../../src/services/SharedResources.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace onsen
+{
+//==============================================================================
+namespace
+{
+    struct Table
+    {
+        std::vector<float> values;
+    };
+} // namespace
+
+TEST (SharedResourcesTest, SharesResourceWhileItIsAlive)
+{
+    int numCreated = 0;
+    auto create = [&numCreated]() {
+        ++numCreated;
+        return std::make_unique<Table> (Table { { 1.0f, 2.0f } });
+    };
+
+    {
+        auto table = SharedResources::get<Table> ("table", create);
+        auto sameTable = SharedResources::get<Table> ("table", create);
+        EXPECT_EQ (table, sameTable);
+        EXPECT_EQ (numCreated, 1);
+        EXPECT_EQ (table->values.size(), 2u);
+
+        auto otherTable = SharedResources::get<Table> ("otherTable", create);
+        EXPECT_NE (table, otherTable);
+        EXPECT_EQ (numCreated, 2);
+        EXPECT_EQ (SharedResources::getNumResources<Table>(), 2);
+    }
+
+    // Released by the last user and created again
+    EXPECT_EQ (SharedResources::getNumResources<Table>(), 0);
+    auto table = SharedResources::get<Table> ("table", create);
+    EXPECT_EQ (numCreated, 3);
+}
+} // namespace onsen
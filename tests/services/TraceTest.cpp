@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+   Trace Test
+  ==============================================================================
+*/
+
+#include "../../src/services/Trace.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace onsen
+{
+//==============================================================================
+namespace
+{
+    int countOf (const std::string& str, const std::string& pattern)
+    {
+        int count = 0;
+        for (auto pos = str.find (pattern); pos != std::string::npos; pos = str.find (pattern, pos + 1))
+        {
+            ++count;
+        }
+        return count;
+    }
+} // namespace
+
+TEST (TraceTest, WritesCompleteEvents)
+{
+    Tracer tracer;
+    {
+        ScopedTrace outer ("outer", tracer);
+        ScopedTrace inner ("inner", tracer);
+    }
+    std::thread ([&tracer]() { ScopedTrace scope ("worker", tracer); }).join();
+
+    std::ostringstream os;
+    tracer.writeChromeTrace (os);
+    const auto json = os.str();
+
+    EXPECT_EQ (json.find ("{\"traceEvents\":["), 0);
+    EXPECT_EQ (countOf (json, "\"ph\":\"X\""), 3);
+    EXPECT_EQ (countOf (json, "{\"name\":\"outer\",\"ph\":\"X\",\"pid\":1,\"tid\":0,"), 1);
+    EXPECT_EQ (countOf (json, "{\"name\":\"inner\",\"ph\":\"X\",\"pid\":1,\"tid\":0,"), 1);
+    // Each thread has its own id
+    EXPECT_EQ (countOf (json, "{\"name\":\"worker\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"), 1);
+    EXPECT_EQ (countOf (json, "\"droppedEvents\":0"), 1);
+
+    // Events are written only once
+    std::ostringstream os2;
+    tracer.writeChromeTrace (os2);
+    EXPECT_EQ (countOf (os2.str(), "\"ph\":\"X\""), 0);
+}
+
+TEST (TraceTest, CountsDroppedEvents)
+{
+    Tracer tracer;
+    for (size_t i = 0; i < Tracer::capacityPerThread + 3; ++i)
+    {
+        tracer.record ("event", 0, 1000);
+    }
+
+    std::ostringstream os;
+    tracer.writeChromeTrace (os);
+    EXPECT_EQ (countOf (os.str(), "\"ph\":\"X\""), static_cast<int> (Tracer::capacityPerThread));
+    EXPECT_EQ (countOf (os.str(), "\"droppedEvents\":3"), 1);
+    EXPECT_EQ (countOf (os.str(), "\"ts\":0.000,\"dur\":1.000"), static_cast<int> (Tracer::capacityPerThread));
+}
+
+TEST (TraceTest, NewTracerAfterDestroyedOneOnSameThread)
+{
+    // The tracer of each iteration is at the same address on the stack
+    for (int i = 0; i < 2; ++i)
+    {
+        Tracer tracer;
+        tracer.record ("event", 0, 1000);
+
+        std::ostringstream os;
+        tracer.writeChromeTrace (os);
+        EXPECT_EQ (countOf (os.str(), "\"ph\":\"X\""), 1);
+    }
+}
+TEST (TraceTest, ThreadsBeyondPreallocatedBuffers)
+{
+    Tracer tracer;
+    for (int i = 0; i < Tracer::numPreallocatedBuffers + 1; ++i)
+    {
+        std::thread ([&tracer]() { ScopedTrace scope ("worker", tracer); }).join();
+    }
+
+    std::ostringstream os;
+    tracer.writeChromeTrace (os);
+    EXPECT_EQ (countOf (os.str(), "\"ph\":\"X\""), Tracer::numPreallocatedBuffers + 1);
+    const auto lastTid = "\"tid\":" + std::to_string (Tracer::numPreallocatedBuffers) + ",";
+    EXPECT_EQ (countOf (os.str(), lastTid), 1);
+}
+} // namespace onsen